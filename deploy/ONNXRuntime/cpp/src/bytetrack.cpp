@@ -0,0 +1,399 @@
+#include "BYTETracker.h"
+#include "cadenceController.h"
+#include "detRecord.h"
+#include "letterbox.h"
+#include "nms.h"
+#include "traceRecorder.h"
+#include "yoloxDecoder.h"
+
+#include <onnxruntime_cxx_api.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <opencv2/opencv.hpp>
+#include <string>
+#include <thread>
+#include <vector>
+
+// The ONNX model of tools/export_onnx.py on the ONNX Runtime CPU execution provider, with
+// the letterbox, output decoding, NMS and BYTETracker of the C++ tracker library, so no
+// step of the pipeline goes through Python or a model conversion.
+//
+// The input and output tensors are bound once, with an IoBinding, to buffers that live for
+// the whole run: the letterbox writes each frame straight into the input tensor and the
+// decoder reads the output tensor where the session wrote it.
+
+#define NMS_THRESH 0.7
+#define BBOX_CONF_THRESH 0.1
+
+// used when the model was exported with a dynamic input size
+static const int DEFAULT_INPUT_W = 1088;
+static const int DEFAULT_INPUT_H = 608;
+static const float MEAN[3] = { 0.485f, 0.456f, 0.406f };
+static const float STD[3] = { 0.229f, 0.224f, 0.225f };
+
+static void usage(const char* prog)
+{
+    std::cerr << "Usage: " << prog << " <bytetrack_s.onnx> <video> [options]" << std::endl;
+    std::cerr << "  --intra-threads <n> threads of an operator (all cores)" << std::endl;
+    std::cerr << "  --inter-threads <n> operators run at once, with --parallel (1)" << std::endl;
+    std::cerr << "  --parallel        run independent branches of the graph concurrently"
+              << std::endl;
+    std::cerr << "  --cadence <n|auto> detect on every n-th frame, or on the frames the cadence"
+              << std::endl;
+    std::cerr << "                    controller picks, and predict the tracks of the others (1)"
+              << std::endl;
+    std::cerr << "  --max-interval <n> longest interval of --cadence auto (4)" << std::endl;
+    std::cerr << "  --budget-ms <ms>  processing time per frame --cadence auto keeps within (none)"
+              << std::endl;
+    std::cerr << "  --fps <rate>      frame rate of the input, for image sequences, which carry none"
+              << std::endl;
+    std::cerr << "                    (the video's, or 30)" << std::endl;
+    std::cerr << "  -o <tracks.txt>   write the tracks in MOT format" << std::endl;
+    std::cerr << "  -r <record.btdr>  record the detections for bytetrack_replay" << std::endl;
+    std::cerr << "  --headless        no window" << std::endl;
+}
+
+// anchors of the three YOLOX strides for an input size
+static int count_anchors(int input_w, int input_h)
+{
+    int count = 0;
+    for (int stride = 8; stride <= 32; stride *= 2)
+        count += (input_w / stride) * (input_h / stride);
+    return count;
+}
+
+static void decode_outputs(bytetrack::YoloxDecoder& decoder,
+                           bytetrack::NmsEngine& nms,
+                           const float* prob,
+                           int num_classes,
+                           int input_w,
+                           int input_h,
+                           float scale,
+                           std::vector<bytetrack::Object>& objects)
+{
+    std::vector<bytetrack::Object>& proposals =
+      decoder.decode(prob, num_classes, input_w, input_h, BBOX_CONF_THRESH);
+
+    std::vector<int> picked;
+    nms.run(proposals, picked);
+
+    int count = picked.size();
+    objects.resize(count);
+    for (int i = 0; i < count; i++) {
+        objects[i] = proposals[picked[i]];
+
+        // adjust offset to original unpadded
+        float x0 = (objects[i].rect.x) / scale;
+        float y0 = (objects[i].rect.y) / scale;
+        float x1 = (objects[i].rect.x + objects[i].rect.width) / scale;
+        float y1 = (objects[i].rect.y + objects[i].rect.height) / scale;
+
+        objects[i].rect.x = x0;
+        objects[i].rect.y = y0;
+        objects[i].rect.width = x1 - x0;
+        objects[i].rect.height = y1 - y0;
+    }
+}
+
+static void draw_tracks(cv::Mat& frame,
+                        bytetrack::BYTETracker& tracker,
+                        const std::vector<bytetrack::STrack>& output_stracks,
+                        int num_frames,
+                        int fps)
+{
+    for (size_t i = 0; i < output_stracks.size(); i++) {
+        const std::vector<float>& tlwh = output_stracks[i].tlwh;
+        bool vertical = tlwh[2] / tlwh[3] > 1.6;
+        if (tlwh[2] * tlwh[3] > 20 && !vertical) {
+            cv::Scalar s = tracker.get_color(output_stracks[i].track_id);
+            cv::putText(frame,
+                        cv::format("%d", output_stracks[i].track_id),
+                        cv::Point(tlwh[0], tlwh[1] - 5),
+                        0,
+                        0.6,
+                        cv::Scalar(0, 0, 255),
+                        2,
+                        cv::LINE_AA);
+            cv::rectangle(frame, cv::Rect(tlwh[0], tlwh[1], tlwh[2], tlwh[3]), s, 2);
+        }
+    }
+    cv::putText(frame,
+                cv::format(
+                  "frame: %d fps: %d num: %d", num_frames, fps, (int)output_stracks.size()),
+                cv::Point(0, 30),
+                0,
+                0.6,
+                cv::Scalar(0, 0, 255),
+                2,
+                cv::LINE_AA);
+}
+
+static int64_t elapsed_us(std::chrono::steady_clock::time_point since)
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() -
+                                                                 since)
+      .count();
+}
+
+static int run(int argc, char** argv)
+{
+    if (argc < 3) {
+        usage(argv[0]);
+        return -1;
+    }
+    std::string model_path = argv[1];
+    std::string video_path = argv[2];
+    std::string tracks_path;
+    std::string record_path;
+    int intra_threads = std::max(1u, std::thread::hardware_concurrency());
+    int inter_threads = 1;
+    bool parallel = false;
+    bool headless = false;
+    int detect_every = 1;
+    bool adaptive = false;
+    bytetrack::CadenceConfig cadence_config;
+    int fps = 0;
+    for (int i = 3; i < argc; i++) {
+        if (!strcmp(argv[i], "--intra-threads") && i + 1 < argc) {
+            intra_threads = std::max(1, atoi(argv[++i]));
+        } else if (!strcmp(argv[i], "--inter-threads") && i + 1 < argc) {
+            inter_threads = std::max(1, atoi(argv[++i]));
+        } else if (!strcmp(argv[i], "--parallel")) {
+            parallel = true;
+        } else if (!strcmp(argv[i], "--cadence") && i + 1 < argc) {
+            adaptive = !strcmp(argv[++i], "auto");
+            detect_every = adaptive ? 1 : std::max(1, atoi(argv[i]));
+        } else if (!strcmp(argv[i], "--max-interval") && i + 1 < argc) {
+            cadence_config.max_interval = std::max(1, atoi(argv[++i]));
+        } else if (!strcmp(argv[i], "--budget-ms") && i + 1 < argc) {
+            cadence_config.budget_ms = atof(argv[++i]);
+        } else if (!strcmp(argv[i], "--fps") && i + 1 < argc) {
+            fps = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "-o") && i + 1 < argc) {
+            tracks_path = argv[++i];
+        } else if (!strcmp(argv[i], "-r") && i + 1 < argc) {
+            record_path = argv[++i];
+        } else if (!strcmp(argv[i], "--headless")) {
+            headless = true;
+        } else {
+            usage(argv[0]);
+            return -1;
+        }
+    }
+    const bool cadence_on = adaptive || detect_every > 1;
+    if (cadence_on && !record_path.empty()) {
+        std::cerr << "Record the detections of every frame and simulate the cadence with "
+                     "bytetrack_replay --cadence"
+                  << std::endl;
+        return -1;
+    }
+
+    Ort::Env env(ORT_LOGGING_LEVEL_WARNING, "bytetrack");
+    Ort::SessionOptions session_options;
+    session_options.SetIntraOpNumThreads(intra_threads);
+    session_options.SetInterOpNumThreads(inter_threads);
+    session_options.SetExecutionMode(parallel ? ExecutionMode::ORT_PARALLEL
+                                              : ExecutionMode::ORT_SEQUENTIAL);
+    session_options.SetGraphOptimizationLevel(GraphOptimizationLevel::ORT_ENABLE_ALL);
+    Ort::Session session(env, model_path.c_str(), session_options);
+
+    Ort::AllocatorWithDefaultOptions allocator;
+    Ort::AllocatedStringPtr input_name = session.GetInputNameAllocated(0, allocator);
+    Ort::AllocatedStringPtr output_name = session.GetOutputNameAllocated(0, allocator);
+
+    // NCHW input and (1, anchors, 5 + classes) output
+    std::vector<int64_t> input_shape =
+      session.GetInputTypeInfo(0).GetTensorTypeAndShapeInfo().GetShape();
+    std::vector<int64_t> output_shape =
+      session.GetOutputTypeInfo(0).GetTensorTypeAndShapeInfo().GetShape();
+    if (input_shape.size() != 4 || output_shape.size() != 3) {
+        std::cerr << model_path << " is not a YOLOX model from tools/export_onnx.py" << std::endl;
+        return -1;
+    }
+    const int input_h = input_shape[2] > 0 ? (int)input_shape[2] : DEFAULT_INPUT_H;
+    const int input_w = input_shape[3] > 0 ? (int)input_shape[3] : DEFAULT_INPUT_W;
+    const int num_classes = output_shape[2] > 0 ? (int)output_shape[2] - 5 : 1;
+    input_shape = { 1, 3, input_h, input_w };
+    output_shape = { 1, count_anchors(input_w, input_h), 5 + num_classes };
+    std::cout << "Network input: " << input_w << "x" << input_h << ", " << num_classes
+              << " classes, " << intra_threads << " intra-op / " << inter_threads
+              << " inter-op threads" << std::endl;
+
+    // the letterbox owns the input buffer; both tensors only wrap memory that outlives them
+    bytetrack::LetterboxPreprocessor letterbox(input_w, input_h, MEAN, STD);
+    std::vector<float> output((size_t)output_shape[1] * output_shape[2]);
+    Ort::MemoryInfo memory_info = Ort::MemoryInfo::CreateCpu(OrtArenaAllocator, OrtMemTypeDefault);
+    Ort::Value input_tensor = Ort::Value::CreateTensor<float>(memory_info,
+                                                              const_cast<float*>(letterbox.data()),
+                                                              letterbox.size(),
+                                                              input_shape.data(),
+                                                              input_shape.size());
+    Ort::Value output_tensor = Ort::Value::CreateTensor<float>(
+      memory_info, output.data(), output.size(), output_shape.data(), output_shape.size());
+    Ort::IoBinding binding(session);
+    binding.BindInput(input_name.get(), input_tensor);
+    binding.BindOutput(output_name.get(), output_tensor);
+    Ort::RunOptions run_options;
+
+    cv::VideoCapture cap(video_path);
+    if (!cap.isOpened()) {
+        std::cerr << "Cannot open " << video_path << std::endl;
+        return -1;
+    }
+    int img_w = cap.get(cv::CAP_PROP_FRAME_WIDTH);
+    int img_h = cap.get(cv::CAP_PROP_FRAME_HEIGHT);
+    // OpenCV reports 0, 1 or 25 fps for image sequences, and the tracker sizes its lost-track
+    // window from the rate
+    if (fps <= 0)
+        fps = (int)cap.get(cv::CAP_PROP_FPS);
+    if (fps <= 0)
+        fps = 30;
+    std::cout << "Total frames: " << (long)cap.get(cv::CAP_PROP_FRAME_COUNT) << std::endl;
+
+    bytetrack::DetRecordWriter recorder;
+    if (!record_path.empty() && !recorder.open(record_path, fps, img_w, img_h))
+        return -1;
+    FILE* tracks_file = nullptr;
+    if (!tracks_path.empty() && (tracks_file = fopen(tracks_path.c_str(), "w")) == nullptr) {
+        std::cerr << "Cannot open " << tracks_path << " for writing" << std::endl;
+        return -1;
+    }
+
+    // BYTETRACK_TRACE=<trace.json> records a timeline of the pipeline stages
+    const char* trace_path = getenv("BYTETRACK_TRACE");
+    if (trace_path != nullptr) {
+        bytetrack::TraceRecorder::start();
+        bytetrack::TraceRecorder::set_thread_name("pipeline");
+    }
+
+    bytetrack::YoloxDecoder decoder;
+    bytetrack::NmsEngine nms(NMS_THRESH);
+    bytetrack::BYTETracker tracker(fps, 30);
+    bytetrack::CadenceController cadence(cadence_config);
+    std::vector<bytetrack::Object> objects;
+    std::vector<bytetrack::STrack> output_stracks;
+    cv::Mat frame;
+    int num_frames = 0;
+    int detected_frames = 0;
+    // letterbox, inference, decode and NMS, tracking
+    int64_t stage_us[4] = { 0, 0, 0, 0 };
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    while (true) {
+        bytetrack::TraceRecorder::set_frame(num_frames + 1);
+        BYTETRACK_TRACE_SCOPE("frame");
+
+        bytetrack::TraceScope decode_trace("decode");
+        cap >> frame;
+        decode_trace.end();
+        if (frame.empty())
+            break;
+        num_frames++;
+
+        // on the frames between detections the Kalman filter alone carries the tracks
+        bool detect = adaptive ? cadence.should_detect() : (num_frames - 1) % detect_every == 0;
+        std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+        if (!detect) {
+            bytetrack::TraceScope predict_trace("predict");
+            output_stracks = tracker.predict_only();
+            predict_trace.end();
+            stage_us[3] += elapsed_us(t0);
+        } else {
+            bytetrack::TraceScope letterbox_trace("letterbox");
+            float scale = letterbox.run(frame, intra_threads);
+            letterbox_trace.end();
+
+            std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+            bytetrack::TraceScope inference_trace("inference");
+            session.Run(run_options, binding);
+            inference_trace.end();
+
+            std::chrono::steady_clock::time_point t2 = std::chrono::steady_clock::now();
+            bytetrack::TraceScope outputs_trace("decode_outputs");
+            decode_outputs(
+              decoder, nms, output.data(), num_classes, input_w, input_h, scale, objects);
+            outputs_trace.end();
+            if (recorder.is_open())
+                recorder.write_frame(objects);
+
+            std::chrono::steady_clock::time_point t3 = std::chrono::steady_clock::now();
+            // associate_and_update() predicts the tracks first: it takes well under a
+            // millisecond, about what starting a thread to overlap it with the inference costs
+            bytetrack::TraceScope track_trace("track");
+            output_stracks = tracker.associate_and_update(objects);
+            track_trace.end();
+            stage_us[0] += std::chrono::duration_cast<std::chrono::microseconds>(t1 - t0).count();
+            stage_us[1] += std::chrono::duration_cast<std::chrono::microseconds>(t2 - t1).count();
+            stage_us[2] += std::chrono::duration_cast<std::chrono::microseconds>(t3 - t2).count();
+            stage_us[3] += elapsed_us(t3);
+            detected_frames++;
+        }
+        if (adaptive)
+            cadence.observe(output_stracks, detect, elapsed_us(t0) / 1000.0);
+
+        if (tracks_file != nullptr) {
+            for (size_t i = 0; i < output_stracks.size(); i++) {
+                const std::vector<float>& tlwh = output_stracks[i].tlwh;
+                fprintf(tracks_file,
+                        "%d,%d,%.2f,%.2f,%.2f,%.2f,%.2f,-1,-1,-1\n",
+                        num_frames,
+                        output_stracks[i].track_id,
+                        tlwh[0],
+                        tlwh[1],
+                        tlwh[2],
+                        tlwh[3],
+                        output_stracks[i].score);
+            }
+        }
+
+        int64_t wall_us = std::max((int64_t)1, elapsed_us(start));
+        if (num_frames % 20 == 0)
+            std::cout << "Processing frame " << num_frames << " ("
+                      << num_frames * 1000000LL / wall_us << " fps)" << std::endl;
+        if (!headless) {
+            BYTETRACK_TRACE_SCOPE("display");
+            draw_tracks(frame,
+                        tracker,
+                        output_stracks,
+                        num_frames,
+                        (int)(num_frames * 1000000LL / wall_us));
+            cv::imshow("bytetrack", frame);
+            if (cv::waitKey(1) > 0)
+                break;
+        }
+    }
+    int64_t wall_us = std::max((int64_t)1, elapsed_us(start));
+
+    cap.release();
+    recorder.close();
+    if (tracks_file != nullptr)
+        fclose(tracks_file);
+    if (trace_path != nullptr)
+        bytetrack::TraceRecorder::dump(trace_path);
+
+    if (cadence_on)
+        printf("detected %d of %d frames, one every %.2f\n",
+               detected_frames,
+               num_frames,
+               (double)num_frames / std::max(detected_frames, 1));
+    if (num_frames > 0) {
+        const char* names[] = { "letterbox", "inference", "decode+nms", "track" };
+        for (int s = 0; s < 4; s++)
+            printf("%-12s %8.2f ms/frame\n", names[s], stage_us[s] / 1000.0 / num_frames);
+    }
+    std::cout << "FPS: " << num_frames * 1000000LL / wall_us << std::endl;
+    return 0;
+}
+
+int main(int argc, char** argv)
+{
+    try {
+        return run(argc, argv);
+    } catch (const Ort::Exception& e) {
+        std::cerr << "ONNX Runtime: " << e.what() << std::endl;
+        return -1;
+    }
+}
@@ -0,0 +1,683 @@
+#include "BYTETracker.h"
+#include "crowdGenerator.h"
+#include "nms.h"
+#include "perfCounters.h"
+#include "yoloxDecoder.h"
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <vector>
+
+// Microbenchmarks of the tracker hot paths. Sizes run from 10 to 10k tracks/detections;
+// the kernels that build the dense (rows + cols)^2 LAP matrix stop at BENCH_MAX_LAP_N,
+// since a 10k x 10k assignment needs several GB. Use --benchmark_format=json (or
+// --benchmark_out=<file> --benchmark_out_format=json) for machine readable results.
+// --perf_counters adds hardware counters per iteration to every benchmark.
+
+#ifndef BENCH_MAX_N
+#define BENCH_MAX_N 10000
+#endif
+#ifndef BENCH_MAX_LAP_N
+#define BENCH_MAX_LAP_N 1000
+#endif
+
+namespace bytetrack {
+
+class BYTETrackerBench
+{
+  public:
+    static std::vector<std::vector<float>> ious(BYTETracker& tracker,
+                                                std::vector<std::vector<float>>& atlbrs,
+                                                std::vector<std::vector<float>>& btlbrs)
+    {
+        return tracker.ious(atlbrs, btlbrs);
+    }
+
+    static std::vector<std::vector<float>> iou_distance(BYTETracker& tracker,
+                                                        std::vector<STrack*>& atracks,
+                                                        std::vector<STrack>& btracks)
+    {
+        int dist_size = 0, dist_size_size = 0;
+        return tracker.iou_distance(atracks, btracks, dist_size, dist_size_size);
+    }
+
+    static double lapjv(BYTETracker& tracker,
+                        const std::vector<std::vector<float>>& cost,
+                        std::vector<int>& rowsol,
+                        std::vector<int>& colsol,
+                        float thresh)
+    {
+        return tracker.lapjv(cost, rowsol, colsol, true, thresh);
+    }
+
+    static std::vector<STrack> joint_stracks(BYTETracker& tracker,
+                                             std::vector<STrack>& tlista,
+                                             std::vector<STrack>& tlistb)
+    {
+        return tracker.joint_stracks(tlista, tlistb);
+    }
+
+    static std::vector<STrack> sub_stracks(BYTETracker& tracker,
+                                           std::vector<STrack>& tlista,
+                                           std::vector<STrack>& tlistb)
+    {
+        return tracker.sub_stracks(tlista, tlistb);
+    }
+
+    static void remove_duplicate_stracks(BYTETracker& tracker,
+                                         std::vector<STrack>& resa,
+                                         std::vector<STrack>& resb,
+                                         std::vector<STrack>& stracksa,
+                                         std::vector<STrack>& stracksb)
+    {
+        tracker.remove_duplicate_stracks(resa, resb, stracksa, stracksb);
+    }
+};
+
+}
+
+using bytetrack::BYTETracker;
+using bytetrack::BYTETrackerBench;
+using bytetrack::NmsEngine;
+using bytetrack::Object;
+using bytetrack::STrack;
+using bytetrack::YoloxDecoder;
+
+static const float BENCH_IMG_W = 1920.f;
+static const float BENCH_IMG_H = 1080.f;
+
+// Pedestrian-like boxes spread over a 1080p frame; a fixed seed keeps runs comparable.
+static std::vector<Object> make_objects(int n, unsigned seed)
+{
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> ux(0.f, BENCH_IMG_W - 60.f);
+    std::uniform_real_distribution<float> uy(0.f, BENCH_IMG_H - 150.f);
+    std::uniform_real_distribution<float> uh(40.f, 150.f);
+    std::uniform_real_distribution<float> us(0.1f, 1.f);
+
+    std::vector<Object> objects(n);
+    for (int i = 0; i < n; i++) {
+        float h = uh(rng);
+        objects[i].rect = cv::Rect_<float>(ux(rng), uy(rng), 0.4f * h, h);
+        objects[i].label = 0;
+        objects[i].prob = us(rng);
+    }
+    return objects;
+}
+
+// The same objects shifted by a few pixels, as the next frame would see them.
+static std::vector<Object> jitter_objects(const std::vector<Object>& objects, unsigned seed)
+{
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> ud(-4.f, 4.f);
+    std::vector<Object> moved = objects;
+    for (size_t i = 0; i < moved.size(); i++) {
+        moved[i].rect.x += ud(rng);
+        moved[i].rect.y += ud(rng);
+    }
+    return moved;
+}
+
+static std::vector<std::vector<float>> to_tlbrs(const std::vector<Object>& objects)
+{
+    std::vector<std::vector<float>> tlbrs(objects.size(), std::vector<float>(4));
+    for (size_t i = 0; i < objects.size(); i++) {
+        tlbrs[i][0] = objects[i].rect.x;
+        tlbrs[i][1] = objects[i].rect.y;
+        tlbrs[i][2] = objects[i].rect.x + objects[i].rect.width;
+        tlbrs[i][3] = objects[i].rect.y + objects[i].rect.height;
+    }
+    return tlbrs;
+}
+
+static std::vector<STrack> to_stracks(const std::vector<Object>& objects)
+{
+    std::vector<STrack> stracks;
+    stracks.reserve(objects.size());
+    for (size_t i = 0; i < objects.size(); i++) {
+        std::vector<float> tlwh = { objects[i].rect.x,
+                                    objects[i].rect.y,
+                                    objects[i].rect.width,
+                                    objects[i].rect.height };
+        stracks.push_back(STrack(tlwh, objects[i].prob));
+    }
+    return stracks;
+}
+
+// Activated tracks with Kalman state and unique ids, as they sit in the tracker lists.
+static std::vector<STrack> make_tracks(int n, unsigned seed)
+{
+    bytetrack::kalman::KalmanFilter kalman_filter;
+    std::vector<STrack> tracks = to_stracks(make_objects(n, seed));
+    for (size_t i = 0; i < tracks.size(); i++)
+        tracks[i].activate(kalman_filter, 1);
+    return tracks;
+}
+
+static void set_sizes(benchmark::State& state, int tracks, int dets)
+{
+    state.counters["tracks"] = tracks;
+    state.counters["dets"] = dets;
+}
+
+// set by --perf_counters when the counters could be opened
+static bytetrack::PerfCounters* bench_perf = nullptr;
+
+// Counts hardware events from its construction, right before the timed loop, to the end of
+// the benchmark and reports them per iteration.
+class BenchPerf
+{
+  public:
+    explicit BenchPerf(benchmark::State& state)
+      : state(state)
+    {
+        if (bench_perf != nullptr)
+            bench_perf->read(start);
+    }
+
+    ~BenchPerf()
+    {
+        if (bench_perf == nullptr || state.iterations() == 0)
+            return;
+        static const char* names[bytetrack::PERF_EVENT_COUNT] = {
+            "cycles", "instructions", "L1D_miss", "LLC_miss", "branch_miss"
+        };
+        bytetrack::PerfSample end;
+        bench_perf->read(end);
+        bytetrack::PerfSample delta = end - start;
+        for (int e = 0; e < bytetrack::PERF_EVENT_COUNT; e++) {
+            if (bench_perf->available(e))
+                state.counters[names[e]] =
+                  benchmark::Counter(delta.values[e], benchmark::Counter::kAvgIterations);
+        }
+        if (delta.values[bytetrack::PERF_CYCLES] > 0)
+            state.counters["IPC"] = (double)delta.values[bytetrack::PERF_INSTRUCTIONS] /
+                                    delta.values[bytetrack::PERF_CYCLES];
+    }
+
+  private:
+    benchmark::State& state;
+    bytetrack::PerfSample start;
+};
+
+static void BM_Ious(benchmark::State& state)
+{
+    const int n_tracks = state.range(0);
+    const int n_dets = state.range(1);
+    BYTETracker tracker;
+    std::vector<Object> objects = make_objects(n_tracks, 1);
+    std::vector<std::vector<float>> atlbrs = to_tlbrs(objects);
+    std::vector<std::vector<float>> btlbrs = to_tlbrs(make_objects(n_dets, 2));
+    BenchPerf perf(state);
+    for (auto _ : state) {
+        std::vector<std::vector<float>> ious = BYTETrackerBench::ious(tracker, atlbrs, btlbrs);
+        benchmark::DoNotOptimize(ious.data());
+    }
+    state.SetItemsProcessed(state.iterations() * n_tracks * n_dets);
+    set_sizes(state, n_tracks, n_dets);
+}
+
+static void BM_IouDistance(benchmark::State& state)
+{
+    const int n_tracks = state.range(0);
+    const int n_dets = state.range(1);
+    BYTETracker tracker;
+    std::vector<STrack> tracks = make_tracks(n_tracks, 1);
+    std::vector<STrack> dets = to_stracks(make_objects(n_dets, 2));
+    std::vector<STrack*> track_ptrs;
+    for (size_t i = 0; i < tracks.size(); i++)
+        track_ptrs.push_back(&tracks[i]);
+    BenchPerf perf(state);
+    for (auto _ : state) {
+        std::vector<std::vector<float>> dists =
+          BYTETrackerBench::iou_distance(tracker, track_ptrs, dets);
+        benchmark::DoNotOptimize(dists.data());
+    }
+    state.SetItemsProcessed(state.iterations() * n_tracks * n_dets);
+    set_sizes(state, n_tracks, n_dets);
+}
+
+static void BM_Lapjv(benchmark::State& state)
+{
+    const int n_tracks = state.range(0);
+    const int n_dets = state.range(1);
+    BYTETracker tracker;
+    // tracks and detections of the same scene one frame apart, like the first association
+    std::vector<Object> objects = make_objects(std::max(n_tracks, n_dets), 1);
+    std::vector<Object> moved = jitter_objects(objects, 2);
+    std::vector<STrack> tracks = to_stracks(objects);
+    std::vector<STrack> dets = to_stracks(moved);
+    tracks.resize(n_tracks, tracks[0]);
+    dets.resize(n_dets, dets[0]);
+    std::vector<STrack*> track_ptrs;
+    for (size_t i = 0; i < tracks.size(); i++)
+        track_ptrs.push_back(&tracks[i]);
+    std::vector<std::vector<float>> cost =
+      BYTETrackerBench::iou_distance(tracker, track_ptrs, dets);
+
+    std::vector<int> rowsol, colsol;
+    BenchPerf perf(state);
+    for (auto _ : state) {
+        double c = BYTETrackerBench::lapjv(tracker, cost, rowsol, colsol, 0.8f);
+        benchmark::DoNotOptimize(c);
+    }
+    set_sizes(state, n_tracks, n_dets);
+}
+
+static void BM_KalmanPredict(benchmark::State& state)
+{
+    const int n_tracks = state.range(0);
+    bytetrack::kalman::KalmanFilter kalman_filter;
+    std::vector<STrack> tracks = make_tracks(n_tracks, 1);
+    std::vector<STrack*> track_ptrs;
+    for (size_t i = 0; i < tracks.size(); i++)
+        track_ptrs.push_back(&tracks[i]);
+    BenchPerf perf(state);
+    for (auto _ : state) {
+        STrack::multi_predict(track_ptrs, kalman_filter);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * n_tracks);
+    set_sizes(state, n_tracks, 0);
+}
+
+static void BM_KalmanUpdate(benchmark::State& state)
+{
+    const int n_tracks = state.range(0);
+    bytetrack::kalman::KalmanFilter kalman_filter;
+    std::vector<STrack> tracks = make_tracks(n_tracks, 1);
+    std::vector<bytetrack::DETECTBOX> measurements(n_tracks);
+    for (int i = 0; i < n_tracks; i++) {
+        for (int k = 0; k < 4; k++)
+            measurements[i][k] = tracks[i].mean[k] * 1.01f;
+    }
+    BenchPerf perf(state);
+    for (auto _ : state) {
+        for (int i = 0; i < n_tracks; i++) {
+            bytetrack::KAL_DATA mc =
+              kalman_filter.update(tracks[i].mean, tracks[i].covariance, measurements[i]);
+            benchmark::DoNotOptimize(mc);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * n_tracks);
+    set_sizes(state, n_tracks, 0);
+}
+
+// Half of the ids in the second list also appear in the first one.
+static void make_overlapping_lists(int na, int nb, std::vector<STrack>& a, std::vector<STrack>& b)
+{
+    a = make_tracks(na, 1);
+    b = make_tracks(nb, 2);
+    for (int i = 0; i < nb / 2 && i < na; i++)
+        b[2 * i].track_id = a[i].track_id;
+}
+
+static void BM_JointStracks(benchmark::State& state)
+{
+    const int na = state.range(0);
+    const int nb = state.range(1);
+    BYTETracker tracker;
+    std::vector<STrack> a, b;
+    make_overlapping_lists(na, nb, a, b);
+    BenchPerf perf(state);
+    for (auto _ : state) {
+        std::vector<STrack> res = BYTETrackerBench::joint_stracks(tracker, a, b);
+        benchmark::DoNotOptimize(res.data());
+    }
+    state.SetItemsProcessed(state.iterations() * (na + nb));
+    set_sizes(state, na, nb);
+}
+
+static void BM_SubStracks(benchmark::State& state)
+{
+    const int na = state.range(0);
+    const int nb = state.range(1);
+    BYTETracker tracker;
+    std::vector<STrack> a, b;
+    make_overlapping_lists(na, nb, a, b);
+    BenchPerf perf(state);
+    for (auto _ : state) {
+        std::vector<STrack> res = BYTETrackerBench::sub_stracks(tracker, a, b);
+        benchmark::DoNotOptimize(res.data());
+    }
+    state.SetItemsProcessed(state.iterations() * (na + nb));
+    set_sizes(state, na, nb);
+}
+
+static void BM_RemoveDuplicateStracks(benchmark::State& state)
+{
+    const int n_tracked = state.range(0);
+    const int n_lost = state.range(1);
+    BYTETracker tracker;
+    // lost tracks partly overlap the tracked ones, so some pairs are real duplicates
+    std::vector<Object> objects = make_objects(std::max(n_tracked, n_lost), 1);
+    std::vector<STrack> tracked = to_stracks(objects);
+    std::vector<STrack> lost = to_stracks(jitter_objects(objects, 2));
+    tracked.resize(n_tracked, tracked[0]);
+    lost.resize(n_lost, lost[0]);
+    BenchPerf perf(state);
+    for (auto _ : state) {
+        std::vector<STrack> resa, resb;
+        BYTETrackerBench::remove_duplicate_stracks(tracker, resa, resb, tracked, lost);
+        benchmark::DoNotOptimize(resa.data());
+        benchmark::DoNotOptimize(resb.data());
+    }
+    set_sizes(state, n_tracked, n_lost);
+}
+
+// Full update() on a scene of n moving objects, measured once the tracks are confirmed.
+static void BM_Update(benchmark::State& state)
+{
+    const int n_objects = state.range(0);
+    const int n_frames = 64;
+    std::vector<std::vector<Object>> frames(n_frames);
+    frames[0] = make_objects(n_objects, 1);
+    for (int f = 1; f < n_frames; f++)
+        frames[f] = jitter_objects(frames[f - 1], f + 1);
+
+    BYTETracker tracker;
+    for (int f = 0; f < 4; f++)
+        tracker.update(frames[f]);
+
+    int f = 4;
+    size_t n_tracks = 0;
+    BenchPerf perf(state);
+    for (auto _ : state) {
+        std::vector<STrack> output = tracker.update(frames[f]);
+        n_tracks = output.size();
+        f = f + 1 < n_frames ? f + 1 : 4;
+    }
+    state.SetItemsProcessed(state.iterations());
+    set_sizes(state, n_tracks, n_objects);
+}
+
+// save() and load() of a tracker holding the confirmed tracks of n moving objects.
+static void BM_SnapshotSave(benchmark::State& state)
+{
+    const int n_objects = state.range(0);
+    std::vector<Object> objects = make_objects(n_objects, 1);
+    BYTETracker tracker;
+    for (int f = 0; f < 4; f++) {
+        tracker.update(objects);
+        objects = jitter_objects(objects, f + 2);
+    }
+
+    std::vector<uint8_t> buffer;
+    BenchPerf perf(state);
+    for (auto _ : state) {
+        tracker.save(buffer);
+        benchmark::DoNotOptimize(buffer.data());
+    }
+    state.SetBytesProcessed(state.iterations() * buffer.size());
+    set_sizes(state, tracker.get_tracked_count() + tracker.get_lost_count(), 0);
+}
+
+static void BM_SnapshotLoad(benchmark::State& state)
+{
+    const int n_objects = state.range(0);
+    std::vector<Object> objects = make_objects(n_objects, 1);
+    BYTETracker tracker;
+    for (int f = 0; f < 4; f++) {
+        tracker.update(objects);
+        objects = jitter_objects(objects, f + 2);
+    }
+    std::vector<uint8_t> buffer;
+    tracker.save(buffer);
+
+    BYTETracker restored;
+    BenchPerf perf(state);
+    for (auto _ : state) {
+        bool loaded = restored.load(buffer);
+        benchmark::DoNotOptimize(loaded);
+    }
+    state.SetBytesProcessed(state.iterations() * buffer.size());
+    set_sizes(state, restored.get_tracked_count() + restored.get_lost_count(), 0);
+}
+
+// Full update() on the synthetic crowd presets: 0 stadium, 1 drone swarm, 2 particles.
+static void BM_UpdateCrowd(benchmark::State& state)
+{
+    const int preset = state.range(0);
+    const int n_objects = state.range(1);
+    bytetrack::CrowdConfig config = preset == 0   ? bytetrack::CrowdConfig::stadium(n_objects)
+                                    : preset == 1 ? bytetrack::CrowdConfig::drone_swarm(n_objects)
+                                                  : bytetrack::CrowdConfig::particles(n_objects);
+    bytetrack::CrowdGenerator generator(config);
+    const int n_frames = 64;
+    std::vector<std::vector<Object>> frames(n_frames);
+    for (int f = 0; f < n_frames; f++)
+        generator.next_frame(frames[f]);
+
+    BYTETracker tracker(config.frame_rate);
+    for (int f = 0; f < 4; f++)
+        tracker.update(frames[f]);
+
+    int f = 4;
+    size_t n_tracks = 0, n_dets = 0;
+    BenchPerf perf(state);
+    for (auto _ : state) {
+        std::vector<STrack> output = tracker.update(frames[f]);
+        n_tracks = output.size();
+        n_dets = frames[f].size();
+        f = f + 1 < n_frames ? f + 1 : 4;
+    }
+    state.SetItemsProcessed(state.iterations());
+    set_sizes(state, n_tracks, n_dets);
+}
+
+// YOLOX output decoding at 1088x608 (22848 anchors) with n anchors above the threshold.
+static void BM_YoloxDecode(benchmark::State& state)
+{
+    const int n_passing = state.range(0);
+    YoloxDecoder decoder;
+    const int n_anchors =
+      (1088 / 8) * (608 / 8) + (1088 / 16) * (608 / 16) + (1088 / 32) * (608 / 32);
+    std::vector<float> feat((size_t)n_anchors * 6);
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<float> offset(-0.5f, 1.5f), log_size(0.0f, 2.0f);
+    std::uniform_real_distribution<float> low(0.0f, 0.3f); // below the threshold once multiplied
+    for (int i = 0; i < n_anchors; i++) {
+        float* p = &feat[(size_t)i * 6];
+        p[0] = offset(rng);
+        p[1] = offset(rng);
+        p[2] = log_size(rng);
+        p[3] = log_size(rng);
+        p[4] = low(rng);
+        p[5] = low(rng);
+    }
+    for (int k = 0; k < n_passing; k++) {
+        float* p = &feat[(size_t)(k * (n_anchors / n_passing)) * 6];
+        p[4] = 0.9f;
+        p[5] = 0.8f;
+    }
+
+    size_t n_proposals = 0;
+    BenchPerf perf(state);
+    for (auto _ : state) {
+        std::vector<Object>& proposals = decoder.decode(feat.data(), 1, 1088, 608, 0.1f);
+        n_proposals = proposals.size();
+        benchmark::DoNotOptimize(proposals.data());
+    }
+    state.SetItemsProcessed(state.iterations() * n_anchors);
+    state.counters["proposals"] = n_proposals;
+}
+
+// Detector-like proposals: n boxes scattered around n / 8 people, with random scores.
+static std::vector<Object> make_proposals(int n, unsigned seed)
+{
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> px(0.0f, 1088.0f), py(0.0f, 608.0f);
+    std::uniform_real_distribution<float> size(0.5f, 1.5f), score(0.1f, 1.0f), jitter(-6.0f, 6.0f);
+    const int people = n / 8 + 1;
+    std::vector<cv::Rect_<float>> boxes;
+    for (int k = 0; k < people; k++)
+        boxes.push_back(cv::Rect_<float>(px(rng), py(rng), 20.0f * size(rng), 50.0f * size(rng)));
+
+    std::vector<Object> proposals(n);
+    for (int k = 0; k < n; k++) {
+        const cv::Rect_<float>& b = boxes[k % people];
+        proposals[k].rect = cv::Rect_<float>(
+          b.x + jitter(rng), b.y + jitter(rng), b.width * size(rng), b.height + jitter(rng));
+        proposals[k].label = 0;
+        proposals[k].prob = score(rng);
+    }
+    return proposals;
+}
+
+// The sort and NMS the demos used before NmsEngine, for comparison.
+static void reference_qsort(std::vector<Object>& objects, int left, int right)
+{
+    int i = left;
+    int j = right;
+    float p = objects[(left + right) / 2].prob;
+    while (i <= j) {
+        while (objects[i].prob > p)
+            i++;
+        while (objects[j].prob < p)
+            j--;
+        if (i <= j) {
+            std::swap(objects[i], objects[j]);
+            i++;
+            j--;
+        }
+    }
+    if (left < j)
+        reference_qsort(objects, left, j);
+    if (i < right)
+        reference_qsort(objects, i, right);
+}
+
+static void reference_nms(std::vector<Object>& objects, std::vector<int>& picked, float threshold)
+{
+    picked.clear();
+    if (objects.empty())
+        return;
+    reference_qsort(objects, 0, objects.size() - 1);
+
+    const int n = objects.size();
+    std::vector<float> areas(n);
+    for (int i = 0; i < n; i++)
+        areas[i] = objects[i].rect.area();
+    for (int i = 0; i < n; i++) {
+        int keep = 1;
+        for (int j = 0; j < (int)picked.size(); j++) {
+            float inter_area = (objects[i].rect & objects[picked[j]].rect).area();
+            float union_area = areas[i] + areas[picked[j]] - inter_area;
+            if (inter_area / union_area > threshold)
+                keep = 0;
+        }
+        if (keep)
+            picked.push_back(i);
+    }
+}
+
+static void BM_NmsReference(benchmark::State& state)
+{
+    const std::vector<Object> proposals = make_proposals(state.range(0), 1);
+    std::vector<int> picked;
+    BenchPerf perf(state);
+    for (auto _ : state) {
+        std::vector<Object> sorted = proposals;
+        reference_nms(sorted, picked, 0.7f);
+        benchmark::DoNotOptimize(picked.data());
+    }
+    state.SetItemsProcessed(state.iterations() * proposals.size());
+    state.counters["kept"] = picked.size();
+}
+
+static void BM_Nms(benchmark::State& state)
+{
+    const std::vector<Object> proposals = make_proposals(state.range(0), 1);
+    NmsEngine nms(0.7f);
+    std::vector<int> picked;
+    BenchPerf perf(state);
+    for (auto _ : state) {
+        nms.run(proposals, picked);
+        benchmark::DoNotOptimize(picked.data());
+    }
+    state.SetItemsProcessed(state.iterations() * proposals.size());
+    state.counters["kept"] = picked.size();
+}
+
+static void dense_args(benchmark::internal::Benchmark* b, int max_n)
+{
+    for (int n = 10; n <= max_n; n *= 10) {
+        b->Args({ n, n });
+        // rectangular shapes: more tracks than detections and the other way round
+        b->Args({ n, std::max(1, n / 2) });
+        b->Args({ std::max(1, n / 2), n });
+    }
+}
+
+static void dense_sizes(benchmark::internal::Benchmark* b)
+{
+    dense_args(b, BENCH_MAX_N);
+}
+
+static void lap_sizes(benchmark::internal::Benchmark* b)
+{
+    dense_args(b, BENCH_MAX_LAP_N);
+}
+
+BENCHMARK(BM_Ious)->Apply(dense_sizes)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_IouDistance)->Apply(dense_sizes)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_Lapjv)->Apply(lap_sizes)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_KalmanPredict)->RangeMultiplier(10)->Range(10, BENCH_MAX_N);
+BENCHMARK(BM_KalmanUpdate)->RangeMultiplier(10)->Range(10, BENCH_MAX_N);
+BENCHMARK(BM_JointStracks)->Apply(dense_sizes)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_SubStracks)->Apply(dense_sizes)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_RemoveDuplicateStracks)->Apply(dense_sizes)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_Update)
+  ->RangeMultiplier(10)
+  ->Range(10, BENCH_MAX_LAP_N)
+  ->Unit(benchmark::kMillisecond);
+
+BENCHMARK(BM_SnapshotSave)
+  ->RangeMultiplier(10)
+  ->Range(10, BENCH_MAX_LAP_N)
+  ->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_SnapshotLoad)
+  ->RangeMultiplier(10)
+  ->Range(10, BENCH_MAX_LAP_N)
+  ->Unit(benchmark::kMicrosecond);
+
+BENCHMARK(BM_UpdateCrowd)
+  ->ArgsProduct({ { 0, 1, 2 }, benchmark::CreateRange(10, BENCH_MAX_LAP_N, 10) })
+  ->Unit(benchmark::kMillisecond);
+
+BENCHMARK(BM_NmsReference)
+  ->RangeMultiplier(10)
+  ->Range(100, BENCH_MAX_N)
+  ->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_Nms)->RangeMultiplier(10)->Range(100, BENCH_MAX_N)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_YoloxDecode)->RangeMultiplier(10)->Range(10, 10000)->Unit(benchmark::kMicrosecond);
+
+int main(int argc, char** argv)
+{
+    // --perf_counters is handled here, everything else by Google Benchmark
+    bytetrack::PerfCounters perf;
+    int kept = 1;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--perf_counters")) {
+            if (perf.open())
+                bench_perf = &perf;
+            else
+                std::cerr << "Hardware counters unavailable (" << perf.get_error()
+                          << "), running without them" << std::endl;
+        } else {
+            argv[kept++] = argv[i];
+        }
+    }
+    argc = kept;
+
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv))
+        return 1;
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
@@ -1,6 +1,11 @@
 #pragma once
 
 #include "STrack.h"
+#include "overloadGuard.h"
+#include "trackerProfiler.h"
+
+#include <climits>
+#include <cstdint>
 
 namespace bytetrack {
 struct Object
@@ -17,9 +22,69 @@ class BYTETracker
     ~BYTETracker();
 
     std::vector<STrack> update(const std::vector<Object>& objects);
-    cv::Scalar get_color(int idx);
+    // update() for a frame taken at `timestamp` seconds, for streams that drop frames or
+    // arrive at a variable rate: the tracks are predicted over the time elapsed since the
+    // previous frame, and lost tracks are removed after track_buffer / 30 seconds instead
+    // of a number of frames. Timestamps must not decrease; do not mix with the calls
+    // without one on the same tracker.
+    std::vector<STrack> update(const std::vector<Object>& objects, double timestamp);
+
+    // update() in two steps. predict_next() moves the tracks to the next frame with the
+    // Kalman filter and builds the candidate lists for association; it only depends on
+    // the previous update, so a pipeline can run it while the detector works on the next
+    // frame. associate_and_update() then matches the detections against the predicted
+    // tracks, and predicts first itself if predict_next() was not called. Both must be
+    // called from the same thread, or serialized by the caller.
+    void predict_next();
+    void predict_next(double timestamp);
+    std::vector<STrack> associate_and_update(const std::vector<Object>& objects);
+    // Steps to the next frame without detections, for the frames a pipeline skips the
+    // detector on: the tracks move with the Kalman filter and nothing is associated, lost
+    // or removed. Returns the activated tracks at their predicted boxes. The lost tracks
+    // keep aging, so max_time_lost still counts frames (or time, with timestamps).
+    std::vector<STrack> predict_only();
+    std::vector<STrack> predict_only(double timestamp);
+    static cv::Scalar get_color(int idx);
+
+    // Latency budget of associate_and_update(). A frame whose association is predicted not
+    // to fit in it is degraded, one OverloadLevel after the other, until it does. Off by
+    // default.
+    void set_overload_config(const OverloadConfig& config) { overload = OverloadGuard(config); }
+    // how the last associate_and_update() went: level, detections left out, time
+    const UpdateStatus& get_status() const { return status; }
+
+    // Snapshot of the tracker between two frames, to resume it in another process or on
+    // another node: frame count, clock, the STrack id counter, and the tracked and lost
+    // tracks with their Kalman states, in the versioned format of trackerSnapshot.h. load()
+    // replaces the state of this tracker, which should be built with the same settings,
+    // and returns false, leaving it untouched, on a buffer that is not a snapshot. The id
+    // counter is only ever raised, so the ids of other trackers in the process stay unique.
+    // Not to be called between predict_next() and associate_and_update().
+    void save(std::vector<uint8_t>& buffer) const;
+    bool load(const uint8_t* data, size_t size);
+    bool load(const std::vector<uint8_t>& buffer);
+
+    // list sizes, to watch memory growth over long runs
+    size_t get_tracked_count() const { return tracked_stracks.size(); }
+    size_t get_lost_count() const { return lost_stracks.size(); }
+    size_t get_removed_count() const { return removed_stracks.size(); }
+
+#ifdef BYTETRACK_PROFILE
+    // per-stage timings, association sizes and track population since the last reset
+    TrackerProfile get_profile() const { return profiler.snapshot(); }
+    void reset_profile() { profiler.reset(); }
+    // counts hardware events per stage with counters opened on the thread calling update()
+    void set_perf_counters(PerfCounters* counters) { profiler.perf = counters; }
+#endif
 
   private:
+    // sets the time of the coming frame: one frame period on, or the given timestamp
+    void advance_clock();
+    void advance_clock(double timestamp);
+
+    // exposes the association kernels below to the microbenchmarks in bench/
+    friend class BYTETrackerBench;
+
     std::vector<STrack*> joint_stracks(std::vector<STrack*>& tlista, std::vector<STrack>& tlistb);
     std::vector<STrack> joint_stracks(std::vector<STrack>& tlista, std::vector<STrack>& tlistb);
 
@@ -36,6 +101,14 @@ class BYTETracker
                            std::vector<std::vector<int>>& matches,
                            std::vector<int>& unmatched_a,
                            std::vector<int>& unmatched_b);
+    // the cheapest pairs first, for overloaded frames
+    void greedy_assignment(std::vector<std::vector<float>>& cost_matrix,
+                           int cost_matrix_size,
+                           int cost_matrix_size_size,
+                           float thresh,
+                           std::vector<std::vector<int>>& matches,
+                           std::vector<int>& unmatched_a,
+                           std::vector<int>& unmatched_b);
     std::vector<std::vector<float>> iou_distance(std::vector<STrack*>& atracks,
                                                  std::vector<STrack>& btracks,
                                                  int& dist_size,
@@ -58,10 +131,31 @@ class BYTETracker
     float match_thresh;
     int frame_id;
     int max_time_lost;
+    float frame_rate;
+
+    // the clock: timestamp of the last frame, and of the coming one with the time step to
+    // it in frames of the nominal rate, once advance_clock() ran for it
+    bool timed; // frames came with timestamps
+    bool clock_advanced;
+    double timestamp;
+    double next_timestamp;
+    float next_dt;
 
     std::vector<STrack> tracked_stracks;
     std::vector<STrack> lost_stracks;
     std::vector<STrack> removed_stracks;
     kalman::KalmanFilter kalman_filter;
+
+    // left by predict_next(), pointing into tracked_stracks and lost_stracks
+    bool predicted;
+    std::vector<STrack*> unconfirmed_pool; // tracked but not activated yet
+    std::vector<STrack*> strack_pool;      // activated and lost tracks
+
+    OverloadGuard overload;
+    UpdateStatus status;
+
+#ifdef BYTETRACK_PROFILE
+    TrackerProfiler profiler;
+#endif
 };
 }
\ No newline at end of file
@@ -1,7 +1,7 @@
 #pragma once
 
 #include "kalmanFilter.h"
-#include <opencv2/opencv.hpp>
+#include <opencv2/core.hpp>
 
 namespace bytetrack {
 enum TrackState
@@ -19,7 +19,9 @@ class STrack
     ~STrack();
 
     std::vector<float> static tlbr_to_tlwh(std::vector<float>& tlbr);
-    void static multi_predict(std::vector<STrack*>& stracks, kalman::KalmanFilter& kalman_filter);
+    void static multi_predict(std::vector<STrack*>& stracks,
+                              kalman::KalmanFilter& kalman_filter,
+                              float dt = 1.f);
     void static_tlwh();
     void static_tlbr();
     std::vector<float> tlwh_to_xyah(std::vector<float> tlwh_tmp);
@@ -27,6 +29,10 @@ class STrack
     void mark_lost();
     void mark_removed();
     int next_id();
+    // the last id handed out, and raising it so that ids up to `last` are not given again,
+    // for a tracker restored from a snapshot
+    static int last_id();
+    static void reserve_ids(int last);
     int end_frame();
 
     void activate(kalman::KalmanFilter& kalman_filter, int frame_id);
@@ -37,6 +43,7 @@ class STrack
     bool is_activated;
     int track_id;
     int state;
+    int label; // class of the detection that started the track
 
     std::vector<float> _tlwh;
     std::vector<float> tlwh;
@@ -44,6 +51,7 @@ class STrack
     int frame_id;
     int tracklet_len;
     int start_frame;
+    double timestamp; // of the frame of the last detection, seconds
 
     KAL_MEAN mean;
     KAL_COVA covariance;
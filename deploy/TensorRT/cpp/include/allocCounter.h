@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstdint>
+
+namespace bytetrack {
+
+// Heap activity of one thread. With BYTETRACK_ALLOC_ACCOUNTING the global operator new and
+// delete are replaced by counting versions (src/allocCounter.cpp); otherwise the counters
+// stay at zero.
+struct AllocCounters
+{
+    uint64_t allocations;
+    uint64_t frees;
+    uint64_t bytes; // requested bytes, not live bytes
+};
+
+inline AllocCounters operator-(const AllocCounters& a, const AllocCounters& b)
+{
+    AllocCounters d;
+    d.allocations = a.allocations - b.allocations;
+    d.frees = a.frees - b.frees;
+    d.bytes = a.bytes - b.bytes;
+    return d;
+}
+
+// counters of the calling thread since it started
+AllocCounters thread_alloc_counters();
+bool alloc_accounting_enabled();
+
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include "BYTETracker.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace bytetrack {
+
+// Parameters of a synthetic detection stream. Sizes are in pixels, speeds in pixels per frame
+// and rates are per object and frame unless noted otherwise.
+struct CrowdConfig
+{
+    int num_objects = 2000; // objects in the scene; leavers are replaced by newcomers
+    int img_w = 1920;
+    int img_h = 1080;
+    int frame_rate = 30;
+
+    // appearance and motion
+    float min_height = 30.f;
+    float max_height = 120.f;
+    float aspect = 0.41f; // box width / height
+    float speed_mean = 1.5f;
+    float speed_std = 0.75f;
+    float turn_std = 0.05f; // heading random walk, radians per frame
+
+    // detector behaviour
+    float occlusion_rate = 0.002f; // chance to disappear behind something
+    int occlusion_frames = 20;     // mean length of an occlusion
+    float dropout = 0.05f;         // chance of a missed detection
+    float low_score_rate = 0.15f;  // chance of a true detection scored below track_thresh
+    float false_positives = 10.f;  // mean number of false positives per frame
+    float score_mean = 0.8f;
+    float score_std = 0.1f;
+    float box_noise = 0.03f; // std of the box jitter, relative to the box height
+
+    uint64_t seed = 1;
+
+    // dense, slow pedestrians seen from far away
+    static CrowdConfig stadium(int num_objects);
+    // fast, small and erratic targets
+    static CrowdConfig drone_swarm(int num_objects);
+    // tiny boxes in brownian motion, no occluders
+    static CrowdConfig particles(int num_objects);
+};
+
+// Deterministic detection stream generator. The random number generator and its
+// distributions are implemented here rather than taken from <random>, so a seed gives the
+// same integer stream regardless of the standard library. The boxes also go through
+// std::log, std::sqrt, std::cos and friends, so they are reproducible only for a given libm
+// and compiler flags (the tree builds with --fast-math).
+class CrowdGenerator
+{
+  public:
+    explicit CrowdGenerator(const CrowdConfig& config);
+
+    // detections of the next frame, sorted by score like the output of NMS
+    void next_frame(std::vector<Object>& objects);
+    // writes num_frames frames to a .btdr detection record
+    bool write_record(const std::string& path, int num_frames);
+
+    int get_frame_id() const { return frame_id; }
+    const CrowdConfig& get_config() const { return config; }
+
+  private:
+    struct Agent
+    {
+        float cx;
+        float cy;
+        float h;
+        float speed;
+        float heading;
+        int occluded; // remaining frames behind an occluder
+    };
+
+    uint32_t next_u32();
+    float uniform(float a = 0.f, float b = 1.f);
+    float normal(float mean = 0.f, float std = 1.f);
+    void spawn(Agent& agent, bool on_edge);
+
+    CrowdConfig config;
+    std::vector<Agent> agents;
+    uint64_t rng_state;
+    int frame_id;
+};
+
+}
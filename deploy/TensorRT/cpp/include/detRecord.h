@@ -0,0 +1,86 @@
+#pragma once
+
+#include "BYTETracker.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace bytetrack {
+
+// Binary detection record (.btdr), little endian:
+//
+//   DetRecordHeader
+//   DetRecordBox[num_boxes]     detections of all frames, packed frame after frame
+//   uint64_t[num_frames + 1]    index of the first box of each frame, plus the total
+//
+// Every section is 8-byte aligned so the file can be mapped and used in place.
+static const char DET_RECORD_MAGIC[4] = { 'B', 'T', 'D', 'R' };
+static const uint32_t DET_RECORD_VERSION = 1;
+
+struct DetRecordHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t frame_rate;
+    uint32_t img_w;
+    uint32_t img_h;
+    uint32_t reserved;
+    uint64_t num_frames;
+    uint64_t num_boxes;
+    uint64_t offsets_pos; // byte position of the frame offset table
+};
+
+struct DetRecordBox
+{
+    float x;
+    float y;
+    float w;
+    float h;
+    float prob;
+    int32_t label;
+};
+
+class DetRecordWriter
+{
+  public:
+    DetRecordWriter();
+    ~DetRecordWriter();
+
+    bool open(const std::string& path, int frame_rate, int img_w, int img_h);
+    bool write_frame(const std::vector<Object>& objects);
+    bool close();
+    bool is_open() const { return file != nullptr; }
+
+  private:
+    FILE* file;
+    DetRecordHeader header;
+    std::vector<uint64_t> offsets;
+    std::vector<DetRecordBox> boxes;
+};
+
+class DetRecordReader
+{
+  public:
+    DetRecordReader();
+    ~DetRecordReader();
+
+    bool open(const std::string& path);
+    void close();
+
+    const DetRecordHeader& get_header() const { return *header; }
+    size_t num_frames() const { return header->num_frames; }
+    size_t num_boxes(size_t frame) const { return offsets[frame + 1] - offsets[frame]; }
+    const DetRecordBox* frame_boxes(size_t frame) const { return boxes + offsets[frame]; }
+    void get_frame(size_t frame, std::vector<Object>& objects) const;
+
+  private:
+    void* data;
+    size_t data_size;
+    const DetRecordHeader* header;
+    const DetRecordBox* boxes;
+    const uint64_t* offsets;
+};
+
+}
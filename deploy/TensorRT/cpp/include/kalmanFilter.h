@@ -10,7 +10,9 @@ class KalmanFilter
     static const double chi2inv95[10];
     KalmanFilter();
     KAL_DATA initiate(const DETECTBOX& measurement);
-    void predict(KAL_MEAN& mean, KAL_COVA& covariance);
+    // dt: time to predict over, in frames of the nominal rate the noise weights are tuned
+    // for; the process noise variance grows linearly with it
+    void predict(KAL_MEAN& mean, KAL_COVA& covariance, float dt = 1.f);
     KAL_HDATA project(const KAL_MEAN& mean, const KAL_COVA& covariance);
     KAL_DATA update(const KAL_MEAN& mean, const KAL_COVA& covariance, const DETECTBOX& measurement);
 
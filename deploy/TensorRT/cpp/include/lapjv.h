@@ -10,13 +10,23 @@
 #define FALSE 0
 #endif
 
+#ifdef BYTETRACK_ALLOC_ACCOUNTING
+// go through operator new so the solver buffers show up in the allocation counters
+#include <new>
+#define LAPJV_MALLOC(size) ::operator new(size, std::nothrow)
+#define LAPJV_FREE(x) ::operator delete(x)
+#else
+#define LAPJV_MALLOC(size) malloc(size)
+#define LAPJV_FREE(x) free(x)
+#endif
+
 #define NEW(x, t, n)                                                                               \
-    if ((x = (t*)malloc(sizeof(t) * (n))) == 0) {                                                  \
+    if ((x = (t*)LAPJV_MALLOC(sizeof(t) * (n))) == 0) {                                            \
         return -1;                                                                                 \
     }
 #define FREE(x)                                                                                    \
     if (x != 0) {                                                                                  \
-        free(x);                                                                                   \
+        LAPJV_FREE(x);                                                                             \
         x = 0;                                                                                     \
     }
 #define SWAP_INDICES(a, b)                                                                         \
@@ -72,6 +82,12 @@ typedef enum fp_t
     FP_DYNAMIC = 3
 } fp_t;
 
-extern int_t lapjv_internal(const uint_t n, cost_t* cost[], int_t* x, int_t* y);
+// When iterations is not NULL, the augmenting row reduction steps and the augmenting path
+// steps taken by the solver are added to it.
+extern int_t lapjv_internal(const uint_t n,
+                            cost_t* cost[],
+                            int_t* x,
+                            int_t* y,
+                            uint_t* iterations = 0);
 
 #endif // LAPJV_H
\ No newline at end of file
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <opencv2/core/core.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace bytetrack {
+
+// Detector input in one pass over the frame: letterbox resize (bilinear, top-left aligned,
+// padded with a constant gray), BGR to RGB, (x / 255 - mean) / std and HWC to CHW, written
+// to a float buffer that is allocated once and reused for every frame of the same size.
+//
+// The resize uses the fixed-point arithmetic of cv::resize(INTER_LINEAR) for 8-bit images
+// and the normalization evaluates the same float expression as the reference code, so the
+// output matches cv::resize + copyMakeBorder + cvtColor + normalize.
+class LetterboxPreprocessor
+{
+  public:
+    // mean and std are per RGB channel, for pixel values scaled to [0, 1]
+    LetterboxPreprocessor(int dst_w,
+                          int dst_h,
+                          const float mean[3],
+                          const float std[3],
+                          int pad_value = 114);
+    ~LetterboxPreprocessor();
+
+    // Fills data() from an 8-bit BGR image, with the rows split over `threads` workers.
+    // Returns the resize factor from the source image to the network input.
+    float run(const cv::Mat& bgr, int threads = 1);
+
+    // dst_w * dst_h floats per channel, 64-byte aligned
+    const float* data() const { return buffer; }
+    size_t size() const { return (size_t)3 * dst_w * dst_h; }
+
+  private:
+    LetterboxPreprocessor(const LetterboxPreprocessor&);
+    LetterboxPreprocessor& operator=(const LetterboxPreprocessor&);
+
+    void prepare(int width, int height, int threads);
+    void resize_row(const cv::Mat& bgr, int src_row, int32_t* out) const;
+    void process_rows(const cv::Mat& bgr, int begin, int end, int32_t* scratch) const;
+
+    int dst_w;
+    int dst_h;
+    float mean[3];
+    float std[3];
+    float pad_values[3]; // normalized padding, per RGB channel
+    float* buffer;
+
+    // resize tables for the current source size
+    int src_w;
+    int src_h;
+    int unpad_w;
+    int unpad_h;
+    float scale;
+    std::vector<int> x_ofs;      // byte offset of the left neighbour, per destination column
+    std::vector<int16_t> x_coef; // left and right weights, 11 bits
+    std::vector<int> y_ofs;      // upper neighbour row, per destination row
+    std::vector<int16_t> y_coef; // upper and lower weights, 11 bits
+    std::vector<int32_t> scratch; // two horizontally resized rows (RGB planes) per worker
+};
+
+}
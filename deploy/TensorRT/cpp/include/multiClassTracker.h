@@ -0,0 +1,77 @@
+#pragma once
+
+#include "BYTETracker.h"
+
+#include <map>
+#include <memory>
+#include <vector>
+
+namespace bytetrack {
+
+// Tracks several object classes at once with one BYTETracker per label, so that a track
+// of one class is never matched to a detection of another. Each frame, the detections are
+// partitioned by label in one pass, every class steps (also those without detections, so
+// their lost tracks keep aging), and the tracks of all classes come back in one list,
+// in label order, with the class in STrack::label. The trackers of a class are created
+// the first time its label is seen. Track ids are unique across classes.
+//
+// The classes are associated on threads of their own when at least two of them hold
+// parallel_min tracks and detections or more, and the machine has more than one hardware
+// thread; otherwise starting a thread costs more than it saves. The ids of the tracks born
+// on such a frame are then handed out in the order the threads get to them.
+class MultiClassTracker
+{
+  public:
+    MultiClassTracker(int frame_rate = 30, int track_buffer = 30, int parallel_min = 100);
+    ~MultiClassTracker();
+
+    // the same calls as BYTETracker, applied to every class
+    std::vector<STrack> update(const std::vector<Object>& objects);
+    std::vector<STrack> update(const std::vector<Object>& objects, double timestamp);
+    void predict_next();
+    void predict_next(double timestamp);
+    std::vector<STrack> associate_and_update(const std::vector<Object>& objects);
+    std::vector<STrack> predict_only();
+    std::vector<STrack> predict_only(double timestamp);
+
+    void set_overload_config(const OverloadConfig& config);
+
+    size_t get_class_count() const { return classes.size(); }
+    size_t get_tracked_count() const;
+    size_t get_lost_count() const;
+    size_t get_removed_count() const;
+    // frames of the last associate_and_update() calls whose classes ran in parallel
+    int get_parallel_frames() const { return parallel_frames; }
+
+#ifdef BYTETRACK_PROFILE
+    // the profile of each class tracker, under its label
+    void print_profiles(std::ostream& os) const;
+#endif
+
+  private:
+    struct ClassTracker
+    {
+        int label;
+        std::unique_ptr<BYTETracker> tracker;
+        std::vector<Object> objects; // of the current frame
+        std::vector<STrack> output;
+    };
+
+    ClassTracker& class_tracker(int label);
+    std::vector<STrack> merge_output();
+
+    int frame_rate;
+    int track_buffer;
+    int parallel_min;
+    OverloadConfig overload_config;
+    int parallel_frames;
+    unsigned hardware_threads; // 0 if unknown
+
+    std::vector<ClassTracker> classes; // in label order
+    std::map<int, size_t> class_index;
+
+    // the timestamp of the coming frame, once predict_next(timestamp) got it
+    bool timestamp_pending;
+    double next_timestamp;
+};
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+namespace bytetrack {
+
+struct OverloadConfig
+{
+    // time an associate_and_update() call should stay within, 0 for no limit
+    float budget_ms = 0.f;
+    // detections considered, by score, from OVERLOAD_CAPPED on
+    int max_detections = 200;
+};
+
+// How far a frame was degraded to fit in the budget. Each level includes the ones before,
+// which cost less tracking accuracy: on crowds, greedy matching swaps a few identities,
+// while without the low score detections the occluded objects are lost.
+enum OverloadLevel
+{
+    OVERLOAD_NONE = 0,
+    OVERLOAD_CAPPED,       // only the max_detections best scored detections are considered
+    OVERLOAD_GREEDY,       // greedy matching instead of the linear assignment
+    OVERLOAD_NO_LOW_SCORE, // no second association with the low score detections
+    OVERLOAD_LEVEL_COUNT
+};
+
+const char* overload_level_name(int level);
+
+// Outcome of the last associate_and_update()
+struct UpdateStatus
+{
+    int level = OVERLOAD_NONE;
+    int dropped_detections = 0; // left out by the cap and the skipped second association
+    float estimated_ms = 0.f;   // time predicted for the chosen level, 0 without a budget
+    float elapsed_ms = 0.f;
+    bool over_budget = false;
+};
+
+// Picks the degradation level of a frame before its association runs. The time of a frame
+// is modeled as a cost per track and detection (Kalman update, copies, list upkeep) plus a
+// cost per association unit: rows x cols for the IoU matrix, and (rows + cols)^2 more for a
+// linear assignment, whose cost matrix is extended to that size. The costs are running
+// means of the measured frames, the one per unit kept for each level since the levels
+// spend their units differently. A machine that gets slower, or a model that is off, thus
+// moves the next frames to a higher level. The least degraded level whose estimate fits
+// the budget is chosen, OVERLOAD_NO_LOW_SCORE when none does.
+class OverloadGuard
+{
+  public:
+    explicit OverloadGuard(const OverloadConfig& config = OverloadConfig());
+
+    bool enabled() const { return config.budget_ms > 0.f; }
+    const OverloadConfig& get_config() const { return config; }
+
+    // pool: activated and lost tracks, tracked: the activated ones still tracked,
+    // unconfirmed: tracks not activated yet, high and low: detections per score class
+    int choose(int pool, int tracked, int unconfirmed, int high, int low, float& estimated_ms);
+    // time of the frame choose() was called for, split into its association steps and the
+    // rest
+    void observe(double association_ns, double other_ns);
+
+  private:
+    double association_units(int level) const;
+    int objects(int level) const;
+    void capped(int level, int& high, int& low) const;
+    static void smooth(double& mean, double value);
+
+    OverloadConfig config;
+    // running means, negative until measured
+    double ns_per_unit[OVERLOAD_LEVEL_COUNT];
+    double ns_per_object;
+
+    // sizes and level of the frame being processed
+    int pool, tracked, unconfirmed, high, low;
+    int level;
+};
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace bytetrack {
+
+enum PerfEvent
+{
+    PERF_CYCLES = 0,
+    PERF_INSTRUCTIONS,
+    PERF_L1D_MISSES, // L1 data cache read misses
+    PERF_LLC_MISSES, // last level cache misses
+    PERF_BRANCH_MISSES,
+    PERF_EVENT_COUNT
+};
+
+const char* perf_event_name(int event);
+
+struct PerfSample
+{
+    uint64_t values[PERF_EVENT_COUNT];
+};
+
+inline PerfSample operator-(const PerfSample& a, const PerfSample& b)
+{
+    PerfSample d;
+    for (int i = 0; i < PERF_EVENT_COUNT; i++)
+        d.values[i] = a.values[i] - b.values[i];
+    return d;
+}
+
+// Hardware counters of the calling thread, read through Linux perf_event_open as one group
+// so all values cover the same interval. Counters the CPU, the kernel or the permissions
+// (see /proc/sys/kernel/perf_event_paranoid) do not allow are left out, and on other
+// systems open() fails; callers are expected to carry on without them.
+class PerfCounters
+{
+  public:
+    PerfCounters();
+    ~PerfCounters();
+
+    // true when at least one counter could be opened
+    bool open();
+    void close();
+
+    bool is_open() const { return leader >= 0; }
+    bool available(int event) const { return slots[event] >= 0; }
+    // bit i set when event i is counted
+    unsigned mask() const;
+    // why open() failed or left counters out
+    const std::string& get_error() const { return error; }
+
+    // running totals since open(), scaled when the kernel had to multiplex the group;
+    // unavailable events read as zero
+    bool read(PerfSample& sample) const;
+
+  private:
+    PerfCounters(const PerfCounters&);
+    PerfCounters& operator=(const PerfCounters&);
+
+    int leader;
+    int fds[PERF_EVENT_COUNT];
+    int slots[PERF_EVENT_COUNT]; // position of each event in the group read, -1 if missing
+    int num_slots;
+    std::string error;
+};
+
+}
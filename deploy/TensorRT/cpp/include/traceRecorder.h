@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace bytetrack {
+
+// Timeline of the demo pipeline in the Chrome trace event format, for chrome://tracing or
+// https://ui.perfetto.dev. Events are complete ("X") events kept in a ring buffer that
+// start() allocates once, so recording costs two clock reads, a relaxed atomic increment
+// and a few stores; once the buffer is full the oldest events are overwritten. Any thread
+// may record. Names must be string literals or otherwise outlive the recorder.
+class TraceRecorder
+{
+  public:
+    static bool start(size_t capacity = 1 << 20);
+    static void stop();
+    static bool enabled() { return events != nullptr; }
+
+    static void record(const char* name, int64_t begin_ns, int64_t end_ns);
+    // frame number attached to the next events of the calling thread
+    static void set_frame(int frame);
+    // label of the calling thread's track in the viewer
+    static void set_thread_name(const char* name);
+
+    // writes the buffered events; call once the recording threads are done
+    static bool dump(const std::string& path);
+
+    static int64_t now_ns();
+
+  private:
+    struct Event
+    {
+        const char* name;
+        int64_t begin_ns;
+        int64_t end_ns;
+        int32_t frame;
+        uint32_t tid;
+    };
+
+    static Event* events;
+};
+
+// Records the lifetime of the scope, or the time until end(), as one event when tracing
+// is enabled.
+class TraceScope
+{
+  public:
+    explicit TraceScope(const char* name)
+      : name(name)
+      , begin_ns(TraceRecorder::enabled() ? TraceRecorder::now_ns() : 0)
+    {}
+
+    ~TraceScope() { end(); }
+
+    void end()
+    {
+        if (name != nullptr && TraceRecorder::enabled())
+            TraceRecorder::record(name, begin_ns, TraceRecorder::now_ns());
+        name = nullptr;
+    }
+
+  private:
+    const char* name;
+    int64_t begin_ns;
+};
+
+}
+
+#define BYTETRACK_TRACE_CONCAT_(a, b) a##b
+#define BYTETRACK_TRACE_CONCAT(a, b) BYTETRACK_TRACE_CONCAT_(a, b)
+#define BYTETRACK_TRACE_SCOPE(name)                                                                \
+    bytetrack::TraceScope BYTETRACK_TRACE_CONCAT(trace_scope_, __LINE__)(name)
@@ -0,0 +1,234 @@
+#pragma once
+
+#include "allocCounter.h"
+#include "perfCounters.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+namespace bytetrack {
+
+// The steps of BYTETracker::update()
+enum TrackerStage
+{
+    STAGE_DETECTIONS = 0,     // split detections by score
+    STAGE_FIRST_ASSOCIATION,  // high score detections vs tracked and lost tracks
+    STAGE_SECOND_ASSOCIATION, // low score detections vs remaining tracked tracks
+    STAGE_UNCONFIRMED,        // unconfirmed tracks and new tracks
+    STAGE_STATE_UPDATE,       // list maintenance
+    STAGE_COUNT
+};
+
+const char* stage_name(int stage);
+
+struct HistogramSnapshot
+{
+    std::vector<uint64_t> counts;
+    uint64_t count;
+    uint64_t sum;
+    uint64_t max;
+
+    double mean() const { return count ? (double)sum / count : 0.0; }
+    // value below which p percent of the samples fall, within the bucket precision
+    uint64_t percentile(double p) const;
+};
+
+// Log-linear histogram in the spirit of HdrHistogram: every power of two is split in
+// 2^SUB_BITS buckets, which keeps the relative error under 1/2^SUB_BITS for any value.
+// A single thread records, any thread may take snapshots; no locks are involved.
+class LatencyHistogram
+{
+  public:
+    static const int SUB_BITS = 4;
+    static const int NUM_BUCKETS = (64 - SUB_BITS + 1) << SUB_BITS;
+
+    LatencyHistogram();
+
+    void record(uint64_t value);
+    HistogramSnapshot snapshot() const;
+    void reset();
+
+    static int bucket_index(uint64_t value);
+    static uint64_t bucket_upper(int index);
+
+  private:
+    std::atomic<uint64_t> counts[NUM_BUCKETS];
+    std::atomic<uint64_t> sum;
+    std::atomic<uint64_t> max;
+};
+
+struct AssociationStats
+{
+    uint64_t calls;
+    uint64_t cells; // sum of rows * cols of the cost matrices
+    uint64_t max_rows;
+    uint64_t max_cols;
+    uint64_t lap_iterations;
+    uint64_t max_lap_iterations;
+};
+
+struct AllocStats
+{
+    uint64_t allocations;
+    uint64_t bytes;
+};
+
+struct TrackerProfile
+{
+    HistogramSnapshot frame; // whole update(), nanoseconds
+    HistogramSnapshot stages[STAGE_COUNT];
+    AssociationStats association[STAGE_COUNT];
+
+    // heap allocations, only filled with BYTETRACK_ALLOC_ACCOUNTING
+    HistogramSnapshot frame_allocations; // allocations per update()
+    AllocStats allocs[STAGE_COUNT];      // totals per stage
+
+    // hardware counter totals per stage, only filled with counters attached
+    unsigned perf_mask; // available PerfEvent bits
+    PerfSample perf[STAGE_COUNT];
+
+    // track population after the last update()
+    int tracked;
+    int unconfirmed;
+    int lost;
+    int removed;
+
+    void print(std::ostream& os) const;
+};
+
+// Per-tracker counters behind BYTETRACK_PROFILE.
+class TrackerProfiler
+{
+  public:
+    TrackerProfiler();
+
+    void record_stage(int stage, uint64_t ns) { stages[stage].record(ns); }
+    void record_frame(uint64_t ns) { frame.record(ns); }
+    // cost matrix size and LAP iterations of one association in the current stage
+    void record_assignment(int rows, int cols, uint64_t lap_iterations);
+    void record_population(int tracked, int unconfirmed, int lost, int removed);
+    void record_stage_allocs(int stage, const AllocCounters& delta);
+    void record_frame_allocs(const AllocCounters& delta);
+    void record_stage_perf(int stage, const PerfSample& delta);
+
+    TrackerProfile snapshot() const;
+    void reset();
+
+    int current_stage;
+    // optional hardware counters of the thread running update(), not owned
+    PerfCounters* perf;
+
+  private:
+    struct AtomicAssociation
+    {
+        std::atomic<uint64_t> calls;
+        std::atomic<uint64_t> cells;
+        std::atomic<uint64_t> max_rows;
+        std::atomic<uint64_t> max_cols;
+        std::atomic<uint64_t> lap_iterations;
+        std::atomic<uint64_t> max_lap_iterations;
+    };
+    struct AtomicAlloc
+    {
+        std::atomic<uint64_t> allocations;
+        std::atomic<uint64_t> bytes;
+    };
+
+    LatencyHistogram frame;
+    LatencyHistogram stages[STAGE_COUNT];
+    AtomicAssociation association[STAGE_COUNT];
+    std::atomic<int> population[4];
+    LatencyHistogram frame_allocs;
+    AtomicAlloc stage_allocs[STAGE_COUNT];
+    std::atomic<uint64_t> stage_perf[STAGE_COUNT][PERF_EVENT_COUNT];
+};
+
+// Times consecutive stages of one update() with a monotonic clock.
+class StageClock
+{
+  public:
+    explicit StageClock(TrackerProfiler& profiler)
+      : profiler(profiler)
+      , begin(std::chrono::steady_clock::now())
+      , last(begin)
+#ifdef BYTETRACK_ALLOC_ACCOUNTING
+      , begin_allocs(thread_alloc_counters())
+      , last_allocs(begin_allocs)
+#endif
+    {
+        if (profiler.perf != nullptr)
+            profiler.perf->read(last_perf);
+    }
+
+    ~StageClock()
+    {
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        close_stage(now);
+        profiler.record_frame(
+          std::chrono::duration_cast<std::chrono::nanoseconds>(now - begin).count());
+#ifdef BYTETRACK_ALLOC_ACCOUNTING
+        profiler.record_frame_allocs(last_allocs - begin_allocs);
+#endif
+    }
+
+    void start(int stage)
+    {
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        close_stage(now);
+        profiler.current_stage = stage;
+        last = now;
+    }
+
+  private:
+    void close_stage(std::chrono::steady_clock::time_point now)
+    {
+        if (profiler.current_stage >= 0) {
+            profiler.record_stage(
+              profiler.current_stage,
+              std::chrono::duration_cast<std::chrono::nanoseconds>(now - last).count());
+        }
+#ifdef BYTETRACK_ALLOC_ACCOUNTING
+        AllocCounters allocs = thread_alloc_counters();
+        if (profiler.current_stage >= 0)
+            profiler.record_stage_allocs(profiler.current_stage, allocs - last_allocs);
+        last_allocs = allocs;
+#endif
+        if (profiler.perf != nullptr) {
+            PerfSample sample;
+            profiler.perf->read(sample);
+            if (profiler.current_stage >= 0)
+                profiler.record_stage_perf(profiler.current_stage, sample - last_perf);
+            last_perf = sample;
+        }
+        profiler.current_stage = -1;
+    }
+
+    TrackerProfiler& profiler;
+    std::chrono::steady_clock::time_point begin;
+    std::chrono::steady_clock::time_point last;
+#ifdef BYTETRACK_ALLOC_ACCOUNTING
+    AllocCounters begin_allocs;
+    AllocCounters last_allocs;
+#endif
+    PerfSample last_perf;
+};
+
+}
+
+// Instrumentation hooks used inside BYTETracker, compiled out unless BYTETRACK_PROFILE is set.
+#ifdef BYTETRACK_PROFILE
+#define BYTETRACK_PROFILE_BEGIN() bytetrack::StageClock stage_clock_(this->profiler)
+#define BYTETRACK_PROFILE_STAGE(stage) stage_clock_.start(bytetrack::stage)
+#define BYTETRACK_PROFILE_ASSIGNMENT(rows, cols, iterations)                                       \
+    this->profiler.record_assignment(rows, cols, iterations)
+#define BYTETRACK_PROFILE_POPULATION(tracked, unconfirmed, lost, removed)                          \
+    this->profiler.record_population(tracked, unconfirmed, lost, removed)
+#else
+#define BYTETRACK_PROFILE_BEGIN()
+#define BYTETRACK_PROFILE_STAGE(stage)
+#define BYTETRACK_PROFILE_ASSIGNMENT(rows, cols, iterations)
+#define BYTETRACK_PROFILE_POPULATION(tracked, unconfirmed, lost, removed)
+#endif
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+
+namespace bytetrack {
+
+// Binary snapshot of a BYTETracker (BYTETracker::save() / load()), little endian:
+//
+//   TrackerSnapshotHeader
+//   TrackerSnapshotTrack[num_tracked]   tracked_stracks, in order
+//   TrackerSnapshotTrack[num_lost]      lost_stracks, in order
+//
+// The records are plain structs of fixed size, so saving and loading are one pass of
+// copies. The tracker settings (frame rate, track_buffer, overload budget) are not part of
+// it: the tracker a snapshot is loaded into is built with them.
+static const char TRACKER_SNAPSHOT_MAGIC[4] = { 'B', 'T', 'S', 'S' };
+static const uint32_t TRACKER_SNAPSHOT_VERSION = 1;
+
+struct TrackerSnapshotHeader
+{
+    char magic[4];
+    uint32_t version;
+    int32_t frame_id;
+    int32_t last_id; // of the STrack id counter
+    uint32_t timed;
+    uint32_t num_tracked;
+    uint32_t num_lost;
+    uint32_t reserved;
+    double timestamp;
+};
+
+struct TrackerSnapshotTrack
+{
+    int32_t track_id;
+    int32_t state;
+    int32_t label;
+    int32_t is_activated;
+    int32_t frame_id;
+    int32_t tracklet_len;
+    int32_t start_frame;
+    // the id is in removed_stracks too: a track that expired on the last frame stays in
+    // lost_stracks until the next one filters it out by id
+    int32_t removed;
+    float score;
+    uint32_t reserved;
+    double timestamp;
+    float tlwh[4]; // box as of the last update, which the association uses
+    float detection_tlwh[4]; // of the detection that started the track
+    float mean[8];
+    // row after row; in full, as the Kalman updates leave it only nearly symmetric
+    float covariance[64];
+};
+}
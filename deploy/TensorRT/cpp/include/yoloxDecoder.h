@@ -0,0 +1,49 @@
+#pragma once
+
+#include "BYTETracker.h"
+
+#include <vector>
+
+namespace bytetrack {
+
+// Turns the raw YOLOX head output into box proposals in input pixels. The output has one
+// row per anchor (x, y, log w, log h, objectness, then one score per class), anchors
+// ordered by stride, then grid row, then grid column.
+//
+// The anchor grid of an input size is built once and reused for every frame of that size.
+// Each anchor is first scored with objectness * best class score, and only the ones above
+// the threshold go through exp and the box math. decode() returns a buffer owned by the
+// decoder, which the caller may sort in place and which the next call overwrites, so one
+// decoder is needed per thread.
+class YoloxDecoder
+{
+  public:
+    YoloxDecoder();
+
+    // Proposals in anchor order, then class order, for every class score with
+    // objectness * score > prob_threshold.
+    std::vector<Object>& decode(const float* feat,
+                                int num_classes,
+                                int input_w,
+                                int input_h,
+                                float prob_threshold);
+
+    int get_num_anchors() const { return (int)grid_x.size(); }
+
+  private:
+    void prepare(int input_w, int input_h);
+
+    int input_w;
+    int input_h;
+
+    // per anchor, for the current input size
+    std::vector<float> grid_x;
+    std::vector<float> grid_y;
+    std::vector<float> strides;
+    std::vector<float> scores;
+
+    std::vector<int> candidates; // anchors above the threshold
+    std::vector<Object> proposals;
+};
+
+}
@@ -1,8 +1,36 @@
 #include "BYTETracker.h"
+#include <algorithm>
+#include <chrono>
 #include <fstream>
+#include <iostream>
 
 namespace bytetrack {
 
+static double elapsed_ns(std::chrono::steady_clock::time_point since)
+{
+    return (double)std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now() - since)
+      .count();
+}
+
+// Keeps the `keep` best scored of the detections, high score ones first; returns how many
+// were dropped.
+static int cap_detections(std::vector<STrack>& high, std::vector<STrack>& low, int keep)
+{
+    int before = (int)(high.size() + low.size());
+    auto by_score = [](const STrack& a, const STrack& b) { return a.score > b.score; };
+    if ((int)high.size() > keep) {
+        std::stable_sort(high.begin(), high.end(), by_score);
+        high.erase(high.begin() + keep, high.end());
+    }
+    keep -= (int)high.size();
+    if ((int)low.size() > keep) {
+        std::stable_sort(low.begin(), low.end(), by_score);
+        low.erase(low.begin() + keep, low.end());
+    }
+    return before - (int)(high.size() + low.size());
+}
+
 BYTETracker::BYTETracker(int frame_rate, int track_buffer)
 {
     track_thresh = 0.5;
@@ -10,7 +38,15 @@ BYTETracker::BYTETracker(int frame_rate, int track_buffer)
     match_thresh = 0.8;
 
     frame_id = 0;
+    predicted = false;
     max_time_lost = int(frame_rate / 30.0 * track_buffer);
+    this->frame_rate = frame_rate;
+
+    timed = false;
+    clock_advanced = false;
+    timestamp = 0;
+    next_timestamp = 0;
+    next_dt = 1.f;
     std::cout << "Init ByteTrack!" << std::endl;
 }
 
@@ -18,9 +54,103 @@ BYTETracker::~BYTETracker() {}
 
 std::vector<STrack> BYTETracker::update(const std::vector<Object>& objects)
 {
+    return associate_and_update(objects);
+}
+
+std::vector<STrack> BYTETracker::update(const std::vector<Object>& objects, double timestamp)
+{
+    predict_next(timestamp);
+    return associate_and_update(objects);
+}
+
+void BYTETracker::advance_clock()
+{
+    this->next_timestamp = this->timestamp + 1.0 / this->frame_rate;
+    this->next_dt = 1.f;
+    this->clock_advanced = true;
+}
+
+void BYTETracker::advance_clock(double timestamp)
+{
+    this->timed = true;
+    this->next_timestamp = timestamp;
+    if (this->frame_id == 0)
+        this->next_dt = 1.f;
+    else
+        this->next_dt = std::max(0.f, float((timestamp - this->timestamp) * this->frame_rate));
+    this->clock_advanced = true;
+}
+
+void BYTETracker::predict_next(double timestamp)
+{
+    if (this->predicted)
+        return;
+    advance_clock(timestamp);
+    predict_next();
+}
+
+void BYTETracker::predict_next()
+{
+    if (this->predicted)
+        return;
+    if (!this->clock_advanced)
+        advance_clock();
+
+    // Add newly detected tracklets to tracked_stracks
+    std::vector<STrack*> tracked_stracks;
+    this->unconfirmed_pool.clear();
+    for (size_t i = 0; i < this->tracked_stracks.size(); i++) {
+        if (!this->tracked_stracks[i].is_activated)
+            this->unconfirmed_pool.push_back(&this->tracked_stracks[i]);
+        else
+            tracked_stracks.push_back(&this->tracked_stracks[i]);
+    }
+
+    this->strack_pool = joint_stracks(tracked_stracks, this->lost_stracks);
+    STrack::multi_predict(this->strack_pool, this->kalman_filter, this->next_dt);
+    this->predicted = true;
+}
+
+std::vector<STrack> BYTETracker::predict_only(double timestamp)
+{
+    predict_next(timestamp);
+    return predict_only();
+}
+
+std::vector<STrack> BYTETracker::predict_only()
+{
+    this->frame_id++;
+    predict_next();
+    this->predicted = false;
+    this->timestamp = this->next_timestamp;
+    this->clock_advanced = false;
+    this->unconfirmed_pool.clear();
+    this->strack_pool.clear();
+
+    // the associations compare against these boxes, so the next detection frame matches
+    // the prediction for the frame before it, as after an update
+    std::vector<STrack> output_stracks;
+    for (size_t i = 0; i < this->tracked_stracks.size(); i++) {
+        STrack& track = this->tracked_stracks[i];
+        if (!track.is_activated)
+            continue;
+        track.static_tlwh();
+        track.static_tlbr();
+        output_stracks.push_back(track);
+    }
+    return output_stracks;
+}
+
+std::vector<STrack> BYTETracker::associate_and_update(const std::vector<Object>& objects)
+{
+    BYTETRACK_PROFILE_BEGIN();
+    auto update_start = std::chrono::steady_clock::now();
 
     ////////////////// Step 1: Get detections //////////////////
+    BYTETRACK_PROFILE_STAGE(STAGE_DETECTIONS);
     this->frame_id++;
+    if (!this->clock_advanced)
+        advance_clock();
     std::vector<STrack> activated_stracks;
     std::vector<STrack> refind_stracks;
     std::vector<STrack> removed_stracks;
@@ -33,9 +163,6 @@ std::vector<STrack> BYTETracker::update(const std::vector<Object>& objects)
     std::vector<STrack> resa, resb;
     std::vector<STrack> output_stracks;
 
-    std::vector<STrack*> unconfirmed;
-    std::vector<STrack*> tracked_stracks;
-    std::vector<STrack*> strack_pool;
     std::vector<STrack*> r_tracked_stracks;
 
     if (objects.size() > 0) {
@@ -50,6 +177,8 @@ std::vector<STrack> BYTETracker::update(const std::vector<Object>& objects)
             float score = objects[i].prob;
 
             STrack strack(STrack::tlbr_to_tlwh(tlbr_), score);
+            strack.timestamp = this->next_timestamp;
+            strack.label = objects[i].label;
             if (score >= track_thresh) {
                 detections.push_back(strack);
             } else {
@@ -58,17 +187,35 @@ std::vector<STrack> BYTETracker::update(const std::vector<Object>& objects)
         }
     }
 
-    // Add newly detected tracklets to tracked_stracks
-    for (size_t i = 0; i < this->tracked_stracks.size(); i++) {
-        if (!this->tracked_stracks[i].is_activated)
-            unconfirmed.push_back(&this->tracked_stracks[i]);
-        else
-            tracked_stracks.push_back(&this->tracked_stracks[i]);
-    }
-
     ////////////////// Step 2: First association, with IoU //////////////////
-    strack_pool = joint_stracks(tracked_stracks, this->lost_stracks);
-    STrack::multi_predict(strack_pool, this->kalman_filter);
+    BYTETRACK_PROFILE_STAGE(STAGE_FIRST_ASSOCIATION);
+    predict_next();
+    this->predicted = false;
+    std::vector<STrack*>& unconfirmed = this->unconfirmed_pool;
+    std::vector<STrack*>& strack_pool = this->strack_pool;
+
+    // shed association work when this frame would not fit in the latency budget
+    this->status = UpdateStatus();
+    if (this->overload.enabled()) {
+        int tracked = 0;
+        for (size_t i = 0; i < strack_pool.size(); i++)
+            tracked += strack_pool[i]->state == TrackState::Tracked;
+        this->status.level = this->overload.choose((int)strack_pool.size(),
+                                                   tracked,
+                                                   (int)unconfirmed.size(),
+                                                   (int)detections.size(),
+                                                   (int)detections_low.size(),
+                                                   this->status.estimated_ms);
+        if (this->status.level >= OVERLOAD_CAPPED)
+            this->status.dropped_detections = cap_detections(
+              detections, detections_low, this->overload.get_config().max_detections);
+        if (this->status.level >= OVERLOAD_NO_LOW_SCORE) {
+            this->status.dropped_detections += (int)detections_low.size();
+            detections_low.clear();
+        }
+    }
+    const bool greedy = this->status.level >= OVERLOAD_GREEDY;
+    auto association_start = std::chrono::steady_clock::now();
 
     std::vector<std::vector<float>> dists;
     int dist_size = 0, dist_size_size = 0;
@@ -76,8 +223,12 @@ std::vector<STrack> BYTETracker::update(const std::vector<Object>& objects)
 
     std::vector<std::vector<int>> matches;
     std::vector<int> u_track, u_detection;
-    linear_assignment(
-      dists, dist_size, dist_size_size, match_thresh, matches, u_track, u_detection);
+    if (greedy)
+        greedy_assignment(
+          dists, dist_size, dist_size_size, match_thresh, matches, u_track, u_detection);
+    else
+        linear_assignment(
+          dists, dist_size, dist_size_size, match_thresh, matches, u_track, u_detection);
 
     for (size_t i = 0; i < matches.size(); i++) {
         STrack* track = strack_pool[matches[i][0]];
@@ -92,6 +243,7 @@ std::vector<STrack> BYTETracker::update(const std::vector<Object>& objects)
     }
 
     ////////////////// Step 3: Second association, using low score dets //////////////////
+    BYTETRACK_PROFILE_STAGE(STAGE_SECOND_ASSOCIATION);
     for (size_t i = 0; i < u_detection.size(); i++) {
         detections_cp.push_back(detections[u_detection[i]]);
     }
@@ -110,7 +262,10 @@ std::vector<STrack> BYTETracker::update(const std::vector<Object>& objects)
     matches.clear();
     u_track.clear();
     u_detection.clear();
-    linear_assignment(dists, dist_size, dist_size_size, 0.5, matches, u_track, u_detection);
+    if (greedy)
+        greedy_assignment(dists, dist_size, dist_size_size, 0.5, matches, u_track, u_detection);
+    else
+        linear_assignment(dists, dist_size, dist_size_size, 0.5, matches, u_track, u_detection);
 
     for (size_t i = 0; i < matches.size(); i++) {
         STrack* track = r_tracked_stracks[matches[i][0]];
@@ -133,6 +288,7 @@ std::vector<STrack> BYTETracker::update(const std::vector<Object>& objects)
     }
 
     // Deal with unconfirmed tracks, usually tracks with only one beginning frame
+    BYTETRACK_PROFILE_STAGE(STAGE_UNCONFIRMED);
     detections.clear();
     detections.assign(detections_cp.begin(), detections_cp.end());
 
@@ -142,7 +298,12 @@ std::vector<STrack> BYTETracker::update(const std::vector<Object>& objects)
     matches.clear();
     std::vector<int> u_unconfirmed;
     u_detection.clear();
-    linear_assignment(dists, dist_size, dist_size_size, 0.7, matches, u_unconfirmed, u_detection);
+    if (greedy)
+        greedy_assignment(
+          dists, dist_size, dist_size_size, 0.7, matches, u_unconfirmed, u_detection);
+    else
+        linear_assignment(
+          dists, dist_size, dist_size_size, 0.7, matches, u_unconfirmed, u_detection);
 
     for (size_t i = 0; i < matches.size(); i++) {
         unconfirmed[matches[i][0]]->update(detections[matches[i][1]], this->frame_id);
@@ -163,10 +324,23 @@ std::vector<STrack> BYTETracker::update(const std::vector<Object>& objects)
         track->activate(this->kalman_filter, this->frame_id);
         activated_stracks.push_back(*track);
     }
+    double association_ns = elapsed_ns(association_start);
 
     ////////////////// Step 5: Update state //////////////////
+    BYTETRACK_PROFILE_STAGE(STAGE_STATE_UPDATE);
+    // the pools point into the lists rebuilt below
+    unconfirmed.clear();
+    strack_pool.clear();
+    this->timestamp = this->next_timestamp;
+    this->clock_advanced = false;
+
     for (size_t i = 0; i < this->lost_stracks.size(); i++) {
-        if (this->frame_id - this->lost_stracks[i].end_frame() > this->max_time_lost) {
+        // with timestamps, half a frame of slack keeps their rounding from deciding
+        bool expired = this->timed ? this->timestamp - this->lost_stracks[i].timestamp >
+                                       (this->max_time_lost + 0.5) / this->frame_rate
+                                   : this->frame_id - this->lost_stracks[i].end_frame() >
+                                       this->max_time_lost;
+        if (expired) {
             this->lost_stracks[i].mark_removed();
             removed_stracks.push_back(this->lost_stracks[i]);
         }
@@ -207,6 +381,16 @@ std::vector<STrack> BYTETracker::update(const std::vector<Object>& objects)
             output_stracks.push_back(this->tracked_stracks[i]);
         }
     }
+    double update_ns = elapsed_ns(update_start);
+    if (this->overload.enabled())
+        this->overload.observe(association_ns, update_ns - association_ns);
+    this->status.elapsed_ms = (float)(update_ns / 1e6);
+    this->status.over_budget = this->overload.enabled() &&
+                               this->status.elapsed_ms > this->overload.get_config().budget_ms;
+    BYTETRACK_PROFILE_POPULATION((int)output_stracks.size(),
+                                 (int)(this->tracked_stracks.size() - output_stracks.size()),
+                                 (int)this->lost_stracks.size(),
+                                 (int)this->removed_stracks.size());
     return output_stracks;
 }
 
@@ -1,5 +1,7 @@
 #include "STrack.h"
 
+#include <atomic>
+
 namespace bytetrack {
 
 STrack::STrack(std::vector<float> tlwh_, float score)
@@ -10,6 +12,7 @@ STrack::STrack(std::vector<float> tlwh_, float score)
     is_activated = false;
     track_id = 0;
     state = TrackState::New;
+    label = 0;
 
     tlwh.resize(4);
     tlbr.resize(4);
@@ -20,6 +23,7 @@ STrack::STrack(std::vector<float> tlwh_, float score)
     tracklet_len = 0;
     this->score = score;
     start_frame = 0;
+    timestamp = 0;
 }
 
 STrack::~STrack() {}
@@ -76,6 +80,7 @@ void STrack::re_activate(STrack& new_track, int frame_id, bool new_id)
     this->state = TrackState::Tracked;
     this->is_activated = true;
     this->frame_id = frame_id;
+    this->timestamp = new_track.timestamp;
     this->score = new_track.score;
     if (new_id)
         this->track_id = next_id();
@@ -84,6 +89,7 @@ void STrack::re_activate(STrack& new_track, int frame_id, bool new_id)
 void STrack::update(STrack& new_track, int frame_id)
 {
     this->frame_id = frame_id;
+    this->timestamp = new_track.timestamp;
     this->tracklet_len++;
 
     std::vector<float> xyah = tlwh_to_xyah(new_track.tlwh);
@@ -165,25 +171,40 @@ void STrack::mark_removed()
     state = TrackState::Removed;
 }
 
+// shared by all trackers, some of which may run on other threads
+static std::atomic<int> _count(0);
+
 int STrack::next_id()
 {
-    static int _count = 0;
-    _count++;
+    return ++_count;
+}
+
+int STrack::last_id()
+{
     return _count;
 }
 
+void STrack::reserve_ids(int last)
+{
+    int count = _count;
+    while (count < last && !_count.compare_exchange_weak(count, last)) {
+    }
+}
+
 int STrack::end_frame()
 {
     return this->frame_id;
 }
 
-void STrack::multi_predict(std::vector<STrack*>& stracks, kalman::KalmanFilter& kalman_filter)
+void STrack::multi_predict(std::vector<STrack*>& stracks,
+                           kalman::KalmanFilter& kalman_filter,
+                           float dt)
 {
     for (size_t i = 0; i < stracks.size(); i++) {
         if (stracks[i]->state != TrackState::Tracked) {
             stracks[i]->mean[7] = 0;
         }
-        kalman_filter.predict(stracks[i]->mean, stracks[i]->covariance);
+        kalman_filter.predict(stracks[i]->mean, stracks[i]->covariance, dt);
     }
 }
 
@@ -0,0 +1,122 @@
+#include "allocCounter.h"
+
+#include <cstdlib>
+#include <new>
+
+namespace bytetrack {
+
+#ifdef BYTETRACK_ALLOC_ACCOUNTING
+
+// plain zero-initialized thread local, safe to touch from inside operator new
+static thread_local AllocCounters counters;
+
+static void* counted_malloc(std::size_t size)
+{
+    if (size == 0)
+        size = 1;
+    void* ptr = malloc(size);
+    if (ptr != nullptr) {
+        counters.allocations++;
+        counters.bytes += size;
+    }
+    return ptr;
+}
+
+static void counted_free(void* ptr)
+{
+    if (ptr == nullptr)
+        return;
+    counters.frees++;
+    free(ptr);
+}
+
+AllocCounters thread_alloc_counters()
+{
+    return counters;
+}
+
+bool alloc_accounting_enabled()
+{
+    return true;
+}
+
+#else
+
+AllocCounters thread_alloc_counters()
+{
+    AllocCounters zero = { 0, 0, 0 };
+    return zero;
+}
+
+bool alloc_accounting_enabled()
+{
+    return false;
+}
+
+#endif
+
+}
+
+#ifdef BYTETRACK_ALLOC_ACCOUNTING
+
+// Replacements of the global allocation functions. They live in the same object file as
+// thread_alloc_counters(), so linking the static library picks them up whenever the
+// counters are read.
+
+void* operator new(std::size_t size)
+{
+    void* ptr = bytetrack::counted_malloc(size);
+    if (ptr == nullptr)
+        throw std::bad_alloc();
+    return ptr;
+}
+
+void* operator new[](std::size_t size)
+{
+    void* ptr = bytetrack::counted_malloc(size);
+    if (ptr == nullptr)
+        throw std::bad_alloc();
+    return ptr;
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+    return bytetrack::counted_malloc(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+    return bytetrack::counted_malloc(size);
+}
+
+void operator delete(void* ptr) noexcept
+{
+    bytetrack::counted_free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept
+{
+    bytetrack::counted_free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept
+{
+    bytetrack::counted_free(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept
+{
+    bytetrack::counted_free(ptr);
+}
+
+void operator delete(void* ptr, const std::nothrow_t&) noexcept
+{
+    bytetrack::counted_free(ptr);
+}
+
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept
+{
+    bytetrack::counted_free(ptr);
+}
+
+#endif
@@ -1,9 +1,18 @@
 #include "BYTETracker.h"
+#include "allocCounter.h"
+#include "detRecord.h"
+#include "letterbox.h"
+#include "multiClassTracker.h"
+#include "nms.h"
+#include "traceRecorder.h"
+#include "yoloxDecoder.h"
 #include "NvInfer.h"
 #include "NvInferPlugin.h"
 #include "cuda_runtime_api.h"
 #include "logging.h"
+#include <algorithm>
 #include <chrono>
+#include <cstdlib>
 #include <dirent.h>
 #include <fstream>
 #include <iostream>
@@ -26,6 +35,7 @@
 #define DEVICE 0 // GPU id
 #define NMS_THRESH 0.7
 #define BBOX_CONF_THRESH 0.1
+#define NUM_CLASSES 1
 
 using namespace nvinfer1;
 
@@ -36,209 +46,20 @@ const char* INPUT_BLOB_NAME = "input_0";
 const char* OUTPUT_BLOB_NAME = "output_0";
 static Logger gLogger;
 
-cv::Mat static_resize(cv::Mat& img)
-{
-    float r = std::min(INPUT_W / (img.cols * 1.0), INPUT_H / (img.rows * 1.0));
-    // r = std::min(r, 1.0f);
-    int unpad_w = r * img.cols;
-    int unpad_h = r * img.rows;
-    cv::Mat re(unpad_h, unpad_w, CV_8UC3);
-    cv::resize(img, re, re.size());
-    cv::Mat out(INPUT_H, INPUT_W, CV_8UC3, cv::Scalar(114, 114, 114));
-    re.copyTo(out(cv::Rect(0, 0, re.cols, re.rows)));
-    return out;
-}
-
-struct GridAndStride
-{
-    int grid0;
-    int grid1;
-    int stride;
-};
-
-static void generate_grids_and_stride(const int target_w,
-                                      const int target_h,
-                                      std::vector<int>& strides,
-                                      std::vector<GridAndStride>& grid_strides)
-{
-    for (auto stride : strides) {
-        int num_grid_w = target_w / stride;
-        int num_grid_h = target_h / stride;
-        for (int g1 = 0; g1 < num_grid_h; g1++) {
-            for (int g0 = 0; g0 < num_grid_w; g0++) {
-                grid_strides.push_back((GridAndStride){ g0, g1, stride });
-            }
-        }
-    }
-}
-
-static inline float intersection_area(const bytetrack::Object& a, const bytetrack::Object& b)
-{
-    cv::Rect_<float> inter = a.rect & b.rect;
-    return inter.area();
-}
-
-static void qsort_descent_inplace(std::vector<bytetrack::Object>& faceobjects, int left, int right)
-{
-    int i = left;
-    int j = right;
-    float p = faceobjects[(left + right) / 2].prob;
-
-    while (i <= j) {
-        while (faceobjects[i].prob > p)
-            i++;
-
-        while (faceobjects[j].prob < p)
-            j--;
-
-        if (i <= j) {
-            // swap
-            std::swap(faceobjects[i], faceobjects[j]);
-
-            i++;
-            j--;
-        }
-    }
-
-    // #pragma omp parallel sections
-    {
-        // #pragma omp section
-        {
-            if (left < j)
-                qsort_descent_inplace(faceobjects, left, j);
-        }
-        // #pragma omp section
-        {
-            if (i < right)
-                qsort_descent_inplace(faceobjects, i, right);
-        }
-    }
-}
-
-static void qsort_descent_inplace(std::vector<bytetrack::Object>& objects)
-{
-    if (objects.empty())
-        return;
-
-    qsort_descent_inplace(objects, 0, objects.size() - 1);
-}
-
-static void nms_sorted_bboxes(const std::vector<bytetrack::Object>& faceobjects,
-                              std::vector<int>& picked,
-                              float nms_threshold)
-{
-    picked.clear();
-
-    const int n = faceobjects.size();
-
-    std::vector<float> areas(n);
-    for (int i = 0; i < n; i++) {
-        areas[i] = faceobjects[i].rect.area();
-    }
-
-    for (int i = 0; i < n; i++) {
-        const bytetrack::Object& a = faceobjects[i];
-
-        int keep = 1;
-        for (int j = 0; j < (int)picked.size(); j++) {
-            const bytetrack::Object& b = faceobjects[picked[j]];
-
-            // intersection over union
-            float inter_area = intersection_area(a, b);
-            float union_area = areas[i] + areas[picked[j]] - inter_area;
-            // float IoU = inter_area / union_area
-            if (inter_area / union_area > nms_threshold)
-                keep = 0;
-        }
-
-        if (keep)
-            picked.push_back(i);
-    }
-}
-
-static void generate_yolox_proposals(std::vector<GridAndStride> grid_strides,
-                                     float* feat_blob,
-                                     float prob_threshold,
-                                     std::vector<bytetrack::Object>& objects)
-{
-    const int num_class = 1;
-
-    const int num_anchors = grid_strides.size();
-
-    for (int anchor_idx = 0; anchor_idx < num_anchors; anchor_idx++) {
-        const int grid0 = grid_strides[anchor_idx].grid0;
-        const int grid1 = grid_strides[anchor_idx].grid1;
-        const int stride = grid_strides[anchor_idx].stride;
-
-        const int basic_pos = anchor_idx * (num_class + 5);
-
-        // yolox/models/yolo_head.py decode logic
-        float x_center = (feat_blob[basic_pos + 0] + grid0) * stride;
-        float y_center = (feat_blob[basic_pos + 1] + grid1) * stride;
-        float w = exp(feat_blob[basic_pos + 2]) * stride;
-        float h = exp(feat_blob[basic_pos + 3]) * stride;
-        float x0 = x_center - w * 0.5f;
-        float y0 = y_center - h * 0.5f;
-
-        float box_objectness = feat_blob[basic_pos + 4];
-        for (int class_idx = 0; class_idx < num_class; class_idx++) {
-            float box_cls_score = feat_blob[basic_pos + 5 + class_idx];
-            float box_prob = box_objectness * box_cls_score;
-            if (box_prob > prob_threshold) {
-                bytetrack::Object obj;
-                obj.rect.x = x0;
-                obj.rect.y = y0;
-                obj.rect.width = w;
-                obj.rect.height = h;
-                obj.label = class_idx;
-                obj.prob = box_prob;
-
-                objects.push_back(obj);
-            }
-
-        } // class loop
-
-    } // point anchor loop
-}
-
-float* blobFromImage(cv::Mat& img)
-{
-    cv::cvtColor(img, img, cv::COLOR_BGR2RGB);
-
-    float* blob = new float[img.total() * 3];
-    int channels = 3;
-    int img_h = img.rows;
-    int img_w = img.cols;
-    std::vector<float> mean = { 0.485, 0.456, 0.406 };
-    std::vector<float> std = { 0.229, 0.224, 0.225 };
-    for (int c = 0; c < channels; c++) {
-        for (int h = 0; h < img_h; h++) {
-            for (int w = 0; w < img_w; w++) {
-                blob[c * img_w * img_h + h * img_w + w] =
-                  (((float)img.at<cv::Vec3b>(h, w)[c]) / 255.0f - mean[c]) / std[c];
-            }
-        }
-    }
-    return blob;
-}
-
-static void decode_outputs(float* prob,
+static void decode_outputs(bytetrack::YoloxDecoder& decoder,
+                           bytetrack::NmsEngine& nms,
+                           const float* prob,
                            std::vector<bytetrack::Object>& objects,
                            float scale,
                            const int img_w,
                            const int img_h)
 {
-    std::vector<bytetrack::Object> proposals;
-    std::vector<int> strides = { 8, 16, 32 };
-    std::vector<GridAndStride> grid_strides;
-    generate_grids_and_stride(INPUT_W, INPUT_H, strides, grid_strides);
-    generate_yolox_proposals(grid_strides, prob, BBOX_CONF_THRESH, proposals);
+    std::vector<bytetrack::Object>& proposals =
+      decoder.decode(prob, NUM_CLASSES, INPUT_W, INPUT_H, BBOX_CONF_THRESH);
     // std::cout << "num of boxes before nms: " << proposals.size() << std::endl;
 
-    qsort_descent_inplace(proposals);
-
     std::vector<int> picked;
-    nms_sorted_bboxes(proposals, picked, NMS_THRESH);
+    nms.run(proposals, picked);
 
     int count = picked.size();
 
@@ -298,7 +119,7 @@ const float color_list[80][3] = {
 };
 
 void doInference(IExecutionContext& context,
-                 float* input,
+                 const float* input,
                  float* output,
                  const int output_size,
                  cv::Size input_shape)
@@ -350,6 +171,7 @@ int tkDNNMain(int argc, char** argv)
 {
     std::string net = "yolo4_fp32.rt";
     std::string input = "../../../../videos/palace.mp4";
+    std::string record;
     int n_classes = 80;
     int n_batch = 1;
     float conf_thresh = 0.3f;
@@ -358,6 +180,8 @@ int tkDNNMain(int argc, char** argv)
         net = argv[1];
     if (argc > 2)
         input = argv[2];
+    if (argc > 3)
+        record = argv[3];
 
     tk::dnn::Yolo3Detection yolo;
     yolo.init(net, n_classes, n_batch, conf_thresh);
@@ -366,27 +190,70 @@ int tkDNNMain(int argc, char** argv)
     if (!cap.isOpened())
         return 0;
 
-    // int img_w = cap.get(cv::CAP_PROP_FRAME_WIDTH);
-    // int img_h = cap.get(cv::CAP_PROP_FRAME_HEIGHT);
+    int img_w = cap.get(cv::CAP_PROP_FRAME_WIDTH);
+    int img_h = cap.get(cv::CAP_PROP_FRAME_HEIGHT);
     int fps = cap.get(cv::CAP_PROP_FPS);
     long nFrame = static_cast<long>(cap.get(cv::CAP_PROP_FRAME_COUNT));
     std::cout << "Total frames: " << nFrame << std::endl;
 
+    // optionally record the detections for offline replay with bytetrack_replay
+    bytetrack::DetRecordWriter recorder;
+    if (!record.empty() && !recorder.open(record, fps, img_w, img_h))
+        return -1;
+
+    // BYTETRACK_TRACE=<trace.json> records a timeline of the pipeline stages
+    const char* trace_path = getenv("BYTETRACK_TRACE");
+    if (trace_path != nullptr) {
+        bytetrack::TraceRecorder::start();
+        bytetrack::TraceRecorder::set_thread_name("pipeline");
+    }
+
+    // BYTETRACK_CLASSES=all or a comma-separated list of the classes to track (0, persons),
+    // each with tracks of its own
+    std::vector<bool> tracked_classes(n_classes, false);
+    const char* classes_env = getenv("BYTETRACK_CLASSES");
+    if (classes_env == nullptr) {
+        tracked_classes[0] = true;
+    } else if (std::string(classes_env) == "all") {
+        tracked_classes.assign(n_classes, true);
+    } else {
+        std::stringstream list(classes_env);
+        std::string item;
+        while (std::getline(list, item, ',')) {
+            int cl = atoi(item.c_str());
+            if (cl < 0 || cl >= n_classes) {
+                std::cerr << "BYTETRACK_CLASSES: no class " << item << std::endl;
+                return -1;
+            }
+            tracked_classes[cl] = true;
+        }
+    }
+    const bool several_classes =
+      std::count(tracked_classes.begin(), tracked_classes.end(), true) > 1;
+
     cv::Mat frame;
     std::vector<cv::Mat> batch_frame;
     std::vector<cv::Mat> batch_dnn_input;
 
     cv::Mat img;
-    bytetrack::BYTETracker tracker(fps, 30);
+    bytetrack::MultiClassTracker tracker(fps, 30);
     int num_frames = 0;
-    int total_ms = 0;
+    int64_t total_us = 0;
+    // heap activity of the capture/inference part and of the tracker
+    bytetrack::AllocCounters detector_allocs = { 0, 0, 0 }, tracker_allocs = { 0, 0, 0 };
     while (true) {
+        bytetrack::AllocCounters frame_start = bytetrack::thread_alloc_counters();
+        bytetrack::TraceRecorder::set_frame(num_frames + 1);
+        BYTETRACK_TRACE_SCOPE("frame");
+
         // clear data structures
         batch_dnn_input.clear();
         batch_frame.clear();
 
         // read new frame
+        bytetrack::TraceScope decode_trace("decode");
         cap >> frame;
+        decode_trace.end();
         if (!frame.data)
             break;
 
@@ -394,16 +261,17 @@ int tkDNNMain(int argc, char** argv)
         batch_frame.push_back(frame);
         batch_dnn_input.push_back(frame.clone());
 
-        // do inference
-
+        // do inference (tkDNN preprocesses, infers and runs NMS in one call)
+        bytetrack::TraceScope detect_trace("detect");
         yolo.update(batch_dnn_input, n_batch);
+        detect_trace.end();
 
         // get bb
         std::vector<bytetrack::Object> objects;
 
         for (size_t i = 0; i < yolo.detected.size(); ++i) {
 
-            if (yolo.detected[i].cl == 0) {
+            if (tracked_classes[yolo.detected[i].cl]) {
 
                 bytetrack::Object obj;
                 obj.rect.x = yolo.detected[i].x;
@@ -416,29 +284,46 @@ int tkDNNMain(int argc, char** argv)
                 objects.push_back(obj);
             }
         }
+        if (recorder.is_open())
+            recorder.write_frame(objects);
 
-        auto start = std::chrono::system_clock::now();
-        // update tracker
-        std::vector<bytetrack::STrack> output_stracks = tracker.update(objects);
+        bytetrack::AllocCounters tracker_start = bytetrack::thread_alloc_counters();
+        auto start = std::chrono::steady_clock::now();
+        // update tracker; associate_and_update() predicts the tracks first, on this thread,
+        // so the prediction is part of the track stage, its timing and its allocations
+        bytetrack::TraceScope track_trace("track");
+        std::vector<bytetrack::STrack> output_stracks = tracker.associate_and_update(objects);
+        track_trace.end();
 
         // get time
-        auto end = std::chrono::system_clock::now();
-        total_ms =
-          total_ms + std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+        auto end = std::chrono::steady_clock::now();
+        bytetrack::AllocCounters tracker_end = bytetrack::thread_alloc_counters();
+        detector_allocs.allocations += (tracker_start - frame_start).allocations;
+        detector_allocs.bytes += (tracker_start - frame_start).bytes;
+        tracker_allocs.allocations += (tracker_end - tracker_start).allocations;
+        tracker_allocs.bytes += (tracker_end - tracker_start).bytes;
+        total_us =
+          total_us + std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
 
         num_frames++;
         if (num_frames % 20 == 0)
             std::cout << "Processing frame " << num_frames << " ("
-                      << total_ms / 1000.0f / num_frames << " ms avg)" << std::endl;
+                      << total_us / 1000.0f / num_frames << " ms avg)" << std::endl;
 
         // draw
+        bytetrack::TraceScope draw_trace("draw");
         for (size_t i = 0; i < output_stracks.size(); i++) {
             std::vector<float> tlwh = output_stracks[i].tlwh;
             bool vertical = tlwh[2] / tlwh[3] > 1.6;
             if (tlwh[2] * tlwh[3] > 20 && !vertical) {
-                cv::Scalar s = tracker.get_color(output_stracks[i].track_id);
+                cv::Scalar s = bytetrack::BYTETracker::get_color(output_stracks[i].track_id);
+                std::string text =
+                  several_classes ? cv::format("%d:%d",
+                                               output_stracks[i].label,
+                                               output_stracks[i].track_id)
+                                  : cv::format("%d", output_stracks[i].track_id);
                 cv::putText(frame,
-                            cv::format("%d", output_stracks[i].track_id),
+                            text,
                             cv::Point(tlwh[0], tlwh[1] - 5),
                             0,
                             0.6,
@@ -451,7 +336,7 @@ int tkDNNMain(int argc, char** argv)
         cv::putText(frame,
                     cv::format("frame: %d fps: %d num: %ld",
                                num_frames,
-                               num_frames * 1000000 / total_ms,
+                               (int)(num_frames * 1000000LL / total_us),
                                output_stracks.size()),
                     cv::Point(0, 30),
                     0,
@@ -460,12 +345,30 @@ int tkDNNMain(int argc, char** argv)
                     2,
                     cv::LINE_AA);
 
+        draw_trace.end();
+
+        BYTETRACK_TRACE_SCOPE("display");
         cv::imshow("detection", frame);
         cv::waitKey(1);
     }
 
     cap.release();
-    std::cout << "FPS: " << num_frames * 1000000 / total_ms << std::endl;
+    recorder.close();
+    if (trace_path != nullptr)
+        bytetrack::TraceRecorder::dump(trace_path);
+    std::cout << "FPS: " << num_frames * 1000000LL / total_us << std::endl;
+
+    if (bytetrack::alloc_accounting_enabled() && num_frames > 0) {
+        printf("Allocations per frame: capture and detection %.1f (%.1f KB), tracker %.1f "
+               "(%.1f KB)\n",
+               (double)detector_allocs.allocations / num_frames,
+               detector_allocs.bytes / 1024.0 / num_frames,
+               (double)tracker_allocs.allocations / num_frames,
+               tracker_allocs.bytes / 1024.0 / num_frames);
+#ifdef BYTETRACK_PROFILE
+        tracker.print_profiles(std::cout);
+#endif
+    }
 
     return 0;
 }
@@ -535,35 +438,39 @@ int main(int argc, char** argv)
     cv::VideoWriter writer(
       "demo.mp4", cv::VideoWriter::fourcc('m', 'p', '4', 'v'), fps, cv::Size(img_w, img_h));
 
+    static const float pixel_mean[3] = { 0.485f, 0.456f, 0.406f };
+    static const float pixel_std[3] = { 0.229f, 0.224f, 0.225f };
+    bytetrack::LetterboxPreprocessor letterbox(INPUT_W, INPUT_H, pixel_mean, pixel_std);
+    const int preprocess_threads = std::max(1, cv::getNumberOfCPUs() / 2);
+    bytetrack::YoloxDecoder decoder;
+    bytetrack::NmsEngine nms(NMS_THRESH);
+
     cv::Mat img;
     bytetrack::BYTETracker tracker(fps, 30);
     int num_frames = 0;
-    int total_ms = 0;
+    int64_t total_us = 0;
     while (true) {
         if (!cap.read(img))
             break;
         num_frames++;
         if (num_frames % 20 == 0) {
             std::cout << "Processing frame " << num_frames << " ("
-                      << num_frames * 1000000 / total_ms << " fps)" << std::endl;
+                      << num_frames * 1000000LL / total_us << " fps)" << std::endl;
         }
         if (img.empty())
             break;
-        cv::Mat pr_img = static_resize(img);
-
-        float* blob;
-        blob = blobFromImage(pr_img);
-        float scale = std::min(INPUT_W / (img.cols * 1.0), INPUT_H / (img.rows * 1.0));
+        // letterbox, BGR to RGB, normalize and HWC to CHW in one pass into a reused buffer
+        float scale = letterbox.run(img, preprocess_threads);
 
         // run inference
-        auto start = std::chrono::system_clock::now();
-        doInference(*context, blob, prob, output_size, pr_img.size());
+        auto start = std::chrono::steady_clock::now();
+        doInference(*context, letterbox.data(), prob, output_size, cv::Size(INPUT_W, INPUT_H));
         std::vector<bytetrack::Object> objects;
-        decode_outputs(prob, objects, scale, img_w, img_h);
+        decode_outputs(decoder, nms, prob, objects, scale, img_w, img_h);
         std::vector<bytetrack::STrack> output_stracks = tracker.update(objects);
-        auto end = std::chrono::system_clock::now();
-        total_ms =
-          total_ms + std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+        auto end = std::chrono::steady_clock::now();
+        total_us =
+          total_us + std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
 
         for (size_t i = 0; i < output_stracks.size(); i++) {
             std::vector<float> tlwh = output_stracks[i].tlwh;
@@ -584,7 +491,7 @@ int main(int argc, char** argv)
         cv::putText(img,
                     cv::format("frame: %d fps: %d num: %ld",
                                num_frames,
-                               num_frames * 1000000 / total_ms,
+                               (int)(num_frames * 1000000LL / total_us),
                                output_stracks.size()),
                     cv::Point(0, 30),
                     0,
@@ -595,14 +502,13 @@ int main(int argc, char** argv)
         cv::imshow("img", img);
         writer.write(img);
 
-        delete blob;
         char c = cv::waitKey(1);
         if (c > 0) {
             break;
         }
     }
     cap.release();
-    std::cout << "FPS: " << num_frames * 1000000 / total_ms << std::endl;
+    std::cout << "FPS: " << num_frames * 1000000LL / total_us << std::endl;
     // destroy the engine
     context->destroy();
     engine->destroy();
@@ -0,0 +1,108 @@
+#include "cadenceController.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace bytetrack {
+
+// weight of the latest frame in the running means of the frame times
+static const double TIME_SMOOTHING = 0.1;
+
+CadenceController::CadenceController(const CadenceConfig& config)
+  : config(config)
+  , interval(1)
+  , since_detection(0)
+  , frames(0)
+  , detected_frames(0)
+  , motion(0.f)
+  , crowding(0.f)
+  , detect_ms(0.0)
+  , predict_ms(0.0)
+{
+    this->config.max_interval = std::max(1, config.max_interval);
+}
+
+bool CadenceController::should_detect()
+{
+    // the first frame, and every interval-th frame after a detection
+    return frames == 0 || since_detection + 1 >= interval;
+}
+
+void CadenceController::observe(const std::vector<STrack>& tracks, bool detected, double frame_ms)
+{
+    frames++;
+    double& mean_ms = detected ? detect_ms : predict_ms;
+    mean_ms = mean_ms == 0.0 ? frame_ms : mean_ms + TIME_SMOOTHING * (frame_ms - mean_ms);
+    if (!detected) {
+        since_detection++;
+        return;
+    }
+    detected_frames++;
+    since_detection = 0;
+
+    // the tracks were just corrected by detections, so their velocities are fresh
+    measure(tracks);
+    int by_motion = 1;
+    if (!tracks.empty()) {
+        float shift = config.max_shift * (1.f - crowding);
+        by_motion = motion > 0.f ? (int)std::min(shift / motion, (float)config.max_interval)
+                                 : config.max_interval;
+    }
+    interval = std::max(1, std::min(std::max(by_motion, budget_interval()), config.max_interval));
+}
+
+void CadenceController::measure(const std::vector<STrack>& tracks)
+{
+    const int n = (int)tracks.size();
+    motion = 0.f;
+    crowding = 0.f;
+    if (n == 0)
+        return;
+
+    // mean is x, y, a, h and their velocities
+    speeds.resize(n);
+    for (int i = 0; i < n; i++) {
+        const KAL_MEAN& mean = tracks[i].mean;
+        float h = std::max(mean(3), 1.f);
+        speeds[i] = (std::sqrt(mean(4) * mean(4) + mean(5) * mean(5)) + std::fabs(mean(7))) / h;
+    }
+    std::vector<float>::iterator p90 = speeds.begin() + (n * 9) / 10;
+    std::nth_element(speeds.begin(), p90, speeds.end());
+    motion = *p90;
+
+    // sweep the boxes by left edge; only boxes starting left of a box's right edge can
+    // overlap it
+    order.resize(n);
+    for (int i = 0; i < n; i++)
+        order[i] = i;
+    std::sort(order.begin(), order.end(), [&tracks](int a, int b) {
+        return tracks[a].tlbr[0] < tracks[b].tlbr[0];
+    });
+    overlapping.assign(n, 0);
+    for (int i = 0; i < n; i++) {
+        const std::vector<float>& a = tracks[order[i]].tlbr;
+        for (int j = i + 1; j < n; j++) {
+            const std::vector<float>& b = tracks[order[j]].tlbr;
+            if (b[0] >= a[2])
+                break;
+            if (b[1] < a[3] && a[1] < b[3]) {
+                overlapping[order[i]] = 1;
+                overlapping[order[j]] = 1;
+            }
+        }
+    }
+    crowding = (float)std::count(overlapping.begin(), overlapping.end(), 1) / n;
+}
+
+// The smallest interval k whose mean frame time, one detection and k - 1 predicted frames,
+// fits in the budget.
+int CadenceController::budget_interval() const
+{
+    if (config.budget_ms <= 0.f || detect_ms <= config.budget_ms)
+        return 1;
+    if (predict_ms >= config.budget_ms)
+        return config.max_interval;
+    return (int)std::ceil((detect_ms - predict_ms) / (config.budget_ms - predict_ms));
+}
+
+}
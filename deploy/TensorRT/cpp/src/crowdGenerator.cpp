@@ -0,0 +1,226 @@
+#include "crowdGenerator.h"
+#include "detRecord.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace bytetrack {
+
+static const float PI = 3.14159265358979f;
+
+CrowdConfig CrowdConfig::stadium(int num_objects)
+{
+    CrowdConfig config;
+    config.num_objects = num_objects;
+    config.img_w = 3840;
+    config.img_h = 2160;
+    config.min_height = 12.f;
+    config.max_height = 40.f;
+    config.speed_mean = 0.3f;
+    config.speed_std = 0.2f;
+    config.turn_std = 0.1f;
+    config.occlusion_rate = 0.004f;
+    config.dropout = 0.08f;
+    config.low_score_rate = 0.25f;
+    config.false_positives = 0.005f * num_objects;
+    return config;
+}
+
+CrowdConfig CrowdConfig::drone_swarm(int num_objects)
+{
+    CrowdConfig config;
+    config.num_objects = num_objects;
+    config.min_height = 8.f;
+    config.max_height = 30.f;
+    config.aspect = 1.f;
+    config.speed_mean = 6.f;
+    config.speed_std = 3.f;
+    config.turn_std = 0.15f;
+    config.occlusion_rate = 0.001f;
+    config.low_score_rate = 0.2f;
+    config.false_positives = 20.f;
+    return config;
+}
+
+CrowdConfig CrowdConfig::particles(int num_objects)
+{
+    CrowdConfig config;
+    config.num_objects = num_objects;
+    config.img_w = 2048;
+    config.img_h = 2048;
+    config.min_height = 4.f;
+    config.max_height = 10.f;
+    config.aspect = 1.f;
+    config.speed_mean = 1.5f;
+    config.speed_std = 1.f;
+    config.turn_std = 1.f;
+    config.occlusion_rate = 0.f;
+    config.dropout = 0.02f;
+    config.low_score_rate = 0.05f;
+    config.false_positives = 5.f;
+    config.box_noise = 0.05f;
+    return config;
+}
+
+CrowdGenerator::CrowdGenerator(const CrowdConfig& config)
+  : config(config)
+  , rng_state(0)
+  , frame_id(0)
+{
+    next_u32();
+    rng_state += config.seed;
+    next_u32();
+
+    agents.resize(std::max(0, config.num_objects));
+    for (size_t i = 0; i < agents.size(); i++)
+        spawn(agents[i], false);
+}
+
+// PCG32 (XSH RR)
+uint32_t CrowdGenerator::next_u32()
+{
+    uint64_t old = rng_state;
+    rng_state = old * 6364136223846793005ULL + 1442695040888963407ULL;
+    uint32_t xorshifted = (uint32_t)(((old >> 18u) ^ old) >> 27u);
+    uint32_t rot = (uint32_t)(old >> 59u);
+    return (xorshifted >> rot) | (xorshifted << ((32 - rot) & 31));
+}
+
+float CrowdGenerator::uniform(float a, float b)
+{
+    return a + (b - a) * ((next_u32() >> 8) * (1.f / 16777216.f));
+}
+
+float CrowdGenerator::normal(float mean, float std)
+{
+    // Box-Muller; 1 - u keeps the log argument in (0, 1]
+    float u1 = 1.f - uniform();
+    float u2 = uniform();
+    return mean + std * std::sqrt(-2.f * std::log(u1)) * std::cos(2.f * PI * u2);
+}
+
+void CrowdGenerator::spawn(Agent& agent, bool on_edge)
+{
+    agent.h = uniform(config.min_height, config.max_height);
+    agent.speed = std::fabs(normal(config.speed_mean, config.speed_std));
+    agent.occluded = 0;
+    if (!on_edge) {
+        agent.cx = uniform(0.f, (float)config.img_w);
+        agent.cy = uniform(0.f, (float)config.img_h);
+        agent.heading = uniform(-PI, PI);
+        return;
+    }
+
+    // enter through a random border, heading roughly inwards
+    int edge = next_u32() % 4;
+    float inward = 0.f;
+    if (edge == 0) {
+        agent.cx = 0.f;
+        agent.cy = uniform(0.f, (float)config.img_h);
+        inward = 0.f;
+    } else if (edge == 1) {
+        agent.cx = (float)config.img_w;
+        agent.cy = uniform(0.f, (float)config.img_h);
+        inward = PI;
+    } else if (edge == 2) {
+        agent.cx = uniform(0.f, (float)config.img_w);
+        agent.cy = 0.f;
+        inward = PI / 2;
+    } else {
+        agent.cx = uniform(0.f, (float)config.img_w);
+        agent.cy = (float)config.img_h;
+        inward = -PI / 2;
+    }
+    agent.heading = inward + uniform(-PI / 3, PI / 3);
+}
+
+void CrowdGenerator::next_frame(std::vector<Object>& objects)
+{
+    frame_id++;
+    objects.clear();
+
+    for (size_t i = 0; i < agents.size(); i++) {
+        Agent& agent = agents[i];
+        agent.heading += normal(0.f, config.turn_std);
+        agent.cx += agent.speed * std::cos(agent.heading);
+        agent.cy += agent.speed * std::sin(agent.heading);
+
+        float margin = agent.h;
+        if (agent.cx < -margin || agent.cx > config.img_w + margin || agent.cy < -margin ||
+            agent.cy > config.img_h + margin) {
+            spawn(agent, true);
+        }
+
+        if (agent.occluded > 0) {
+            agent.occluded--;
+            continue;
+        }
+        if (uniform() < config.occlusion_rate) {
+            float frames = normal((float)config.occlusion_frames, config.occlusion_frames / 3.f);
+            agent.occluded = std::max(1, (int)std::lround(frames));
+            continue;
+        }
+        if (uniform() < config.dropout)
+            continue;
+
+        float h = agent.h * (1.f + normal(0.f, config.box_noise));
+        float w = h * config.aspect;
+        Object obj;
+        obj.rect.x = agent.cx - w / 2 + normal(0.f, config.box_noise * agent.h);
+        obj.rect.y = agent.cy - h / 2 + normal(0.f, config.box_noise * agent.h);
+        obj.rect.width = w;
+        obj.rect.height = h;
+        obj.label = 0;
+        if (uniform() < config.low_score_rate)
+            obj.prob = uniform(0.1f, 0.5f);
+        else
+            obj.prob = std::min(1.f, std::max(0.1f, normal(config.score_mean, config.score_std)));
+        objects.push_back(obj);
+    }
+
+    // Poisson distributed false positives (normal approximation for large means)
+    int num_fp = 0;
+    if (config.false_positives > 30.f) {
+        num_fp = std::max(
+          0, (int)std::lround(normal(config.false_positives, std::sqrt(config.false_positives))));
+    } else if (config.false_positives > 0.f) {
+        float limit = std::exp(-config.false_positives);
+        float p = uniform();
+        while (p > limit) {
+            num_fp++;
+            p *= uniform();
+        }
+    }
+    for (int i = 0; i < num_fp; i++) {
+        float h = uniform(config.min_height, config.max_height);
+        Object obj;
+        obj.rect.x = uniform(0.f, (float)config.img_w);
+        obj.rect.y = uniform(0.f, (float)config.img_h);
+        obj.rect.width = h * config.aspect;
+        obj.rect.height = h;
+        obj.label = 0;
+        obj.prob = uniform(0.1f, 0.6f);
+        objects.push_back(obj);
+    }
+
+    std::stable_sort(objects.begin(), objects.end(), [](const Object& a, const Object& b) {
+        return a.prob > b.prob;
+    });
+}
+
+bool CrowdGenerator::write_record(const std::string& path, int num_frames)
+{
+    DetRecordWriter writer;
+    if (!writer.open(path, config.frame_rate, config.img_w, config.img_h))
+        return false;
+
+    std::vector<Object> objects;
+    for (int f = 0; f < num_frames; f++) {
+        next_frame(objects);
+        if (!writer.write_frame(objects))
+            return false;
+    }
+    return writer.close();
+}
+
+}
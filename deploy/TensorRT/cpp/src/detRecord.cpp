@@ -0,0 +1,190 @@
+#include "detRecord.h"
+
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace bytetrack {
+
+DetRecordWriter::DetRecordWriter()
+  : file(nullptr)
+{
+    memset(&header, 0, sizeof(header));
+}
+
+DetRecordWriter::~DetRecordWriter()
+{
+    close();
+}
+
+bool DetRecordWriter::open(const std::string& path, int frame_rate, int img_w, int img_h)
+{
+    close();
+    file = fopen(path.c_str(), "wb");
+    if (file == nullptr) {
+        std::cerr << "Cannot open detection record " << path << " for writing" << std::endl;
+        return false;
+    }
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, DET_RECORD_MAGIC, sizeof(header.magic));
+    header.version = DET_RECORD_VERSION;
+    header.frame_rate = frame_rate;
+    header.img_w = img_w;
+    header.img_h = img_h;
+
+    offsets.clear();
+    offsets.push_back(0);
+
+    // the header is rewritten with the final counts on close()
+    return fwrite(&header, sizeof(header), 1, file) == 1;
+}
+
+bool DetRecordWriter::write_frame(const std::vector<Object>& objects)
+{
+    if (file == nullptr)
+        return false;
+
+    boxes.resize(objects.size());
+    for (size_t i = 0; i < objects.size(); i++) {
+        boxes[i].x = objects[i].rect.x;
+        boxes[i].y = objects[i].rect.y;
+        boxes[i].w = objects[i].rect.width;
+        boxes[i].h = objects[i].rect.height;
+        boxes[i].prob = objects[i].prob;
+        boxes[i].label = objects[i].label;
+    }
+    if (!boxes.empty() &&
+        fwrite(boxes.data(), sizeof(DetRecordBox), boxes.size(), file) != boxes.size())
+        return false;
+
+    header.num_boxes += boxes.size();
+    header.num_frames++;
+    offsets.push_back(header.num_boxes);
+    return true;
+}
+
+bool DetRecordWriter::close()
+{
+    if (file == nullptr)
+        return true;
+
+    header.offsets_pos = sizeof(DetRecordHeader) + header.num_boxes * sizeof(DetRecordBox);
+    bool ok = fwrite(offsets.data(), sizeof(uint64_t), offsets.size(), file) == offsets.size();
+    ok = ok && fseek(file, 0, SEEK_SET) == 0;
+    ok = ok && fwrite(&header, sizeof(header), 1, file) == 1;
+    ok = (fclose(file) == 0) && ok;
+    file = nullptr;
+    if (!ok)
+        std::cerr << "Failed to finalize detection record" << std::endl;
+    return ok;
+}
+
+DetRecordReader::DetRecordReader()
+  : data(nullptr)
+  , data_size(0)
+  , header(nullptr)
+  , boxes(nullptr)
+  , offsets(nullptr)
+{}
+
+DetRecordReader::~DetRecordReader()
+{
+    close();
+}
+
+bool DetRecordReader::open(const std::string& path)
+{
+    close();
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "Cannot open detection record " << path << std::endl;
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(DetRecordHeader)) {
+        std::cerr << "Detection record " << path << " is truncated" << std::endl;
+        ::close(fd);
+        return false;
+    }
+
+    data_size = st.st_size;
+    data = mmap(nullptr, data_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (data == MAP_FAILED) {
+        std::cerr << "Cannot map detection record " << path << std::endl;
+        data = nullptr;
+        data_size = 0;
+        return false;
+    }
+
+    const char* base = static_cast<const char*>(data);
+    header = reinterpret_cast<const DetRecordHeader*>(base);
+    if (memcmp(header->magic, DET_RECORD_MAGIC, sizeof(header->magic)) != 0 ||
+        header->version != DET_RECORD_VERSION) {
+        std::cerr << path << " is not a version " << DET_RECORD_VERSION << " detection record"
+                  << std::endl;
+        close();
+        return false;
+    }
+    // the counts are checked against the file size before they are multiplied, so that a
+    // corrupt header cannot overflow past the checks
+    const size_t body_size = data_size - sizeof(DetRecordHeader);
+    bool valid = header->num_boxes <= body_size / sizeof(DetRecordBox);
+    size_t boxes_end = 0;
+    if (valid) {
+        boxes_end = sizeof(DetRecordHeader) + header->num_boxes * sizeof(DetRecordBox);
+        valid = header->offsets_pos == boxes_end &&
+                header->num_frames < (data_size - boxes_end) / sizeof(uint64_t);
+    }
+    if (!valid) {
+        std::cerr << "Detection record " << path << " is truncated" << std::endl;
+        close();
+        return false;
+    }
+
+    boxes = reinterpret_cast<const DetRecordBox*>(base + sizeof(DetRecordHeader));
+    offsets = reinterpret_cast<const uint64_t*>(base + header->offsets_pos);
+    // frame_boxes() and num_boxes() index the boxes with the offsets unchecked
+    valid = offsets[0] == 0 && offsets[header->num_frames] == header->num_boxes;
+    for (size_t i = 0; valid && i < header->num_frames; i++)
+        valid = offsets[i] <= offsets[i + 1];
+    if (!valid) {
+        std::cerr << "Detection record " << path << " has a corrupt frame index" << std::endl;
+        close();
+        return false;
+    }
+    madvise(data, data_size, MADV_SEQUENTIAL);
+    return true;
+}
+
+void DetRecordReader::close()
+{
+    if (data != nullptr)
+        munmap(data, data_size);
+    data = nullptr;
+    data_size = 0;
+    header = nullptr;
+    boxes = nullptr;
+    offsets = nullptr;
+}
+
+void DetRecordReader::get_frame(size_t frame, std::vector<Object>& objects) const
+{
+    const DetRecordBox* b = frame_boxes(frame);
+    size_t n = num_boxes(frame);
+    objects.resize(n);
+    for (size_t i = 0; i < n; i++) {
+        objects[i].rect.x = b[i].x;
+        objects[i].rect.y = b[i].y;
+        objects[i].rect.width = b[i].w;
+        objects[i].rect.height = b[i].h;
+        objects[i].prob = b[i].prob;
+        objects[i].label = b[i].label;
+    }
+}
+
+}
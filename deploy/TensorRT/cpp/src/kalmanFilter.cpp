@@ -50,7 +50,7 @@ KAL_DATA KalmanFilter::initiate(const DETECTBOX& measurement)
     return std::make_pair(mean, var);
 }
 
-void KalmanFilter::predict(KAL_MEAN& mean, KAL_COVA& covariance)
+void KalmanFilter::predict(KAL_MEAN& mean, KAL_COVA& covariance, float dt)
 {
     // revise the data;
     DETECTBOX std_pos;
@@ -63,9 +63,16 @@ void KalmanFilter::predict(KAL_MEAN& mean, KAL_COVA& covariance)
     tmp.block<1, 4>(0, 0) = std_pos;
     tmp.block<1, 4>(0, 4) = std_vel;
     tmp = tmp.array().square();
+    Eigen::Matrix<float, 8, 8, Eigen::RowMajor> motion_mat = this->_motion_mat;
+    if (dt != 1.f) {
+        tmp *= dt;
+        for (int i = 0; i < 4; i++) {
+            motion_mat(i, 4 + i) = dt;
+        }
+    }
     KAL_COVA motion_cov = tmp.asDiagonal();
-    KAL_MEAN mean1 = this->_motion_mat * mean.transpose();
-    KAL_COVA covariance1 = this->_motion_mat * covariance * (_motion_mat.transpose());
+    KAL_MEAN mean1 = motion_mat * mean.transpose();
+    KAL_COVA covariance1 = motion_mat * covariance * (motion_mat.transpose());
     covariance1 += motion_cov;
 
     mean = mean1;
@@ -75,7 +75,8 @@ int_t _carr_dense(const uint_t n,
                   int_t* free_rows,
                   int_t* x,
                   int_t* y,
-                  cost_t* v)
+                  cost_t* v,
+                  uint_t* iterations)
 {
     uint_t current = 0;
     int_t new_free_rows = 0;
@@ -148,6 +149,8 @@ int_t _carr_dense(const uint_t n,
         x[free_i] = j1;
         y[j1] = free_i;
     }
+    if (iterations)
+        *iterations += rr_cnt;
     return new_free_rows;
 }
 
@@ -291,7 +294,8 @@ int_t _ca_dense(const uint_t n,
                 int_t* free_rows,
                 int_t* x,
                 int_t* y,
-                cost_t* v)
+                cost_t* v,
+                uint_t* iterations)
 {
     int_t* pred;
 
@@ -318,6 +322,8 @@ int_t _ca_dense(const uint_t n,
                 ASSERT(FALSE);
             }
         }
+        if (iterations)
+            *iterations += k;
     }
     FREE(pred);
     return 0;
@@ -325,7 +331,7 @@ int_t _ca_dense(const uint_t n,
 
 /** Solve dense sparse LAP.
  */
-int lapjv_internal(const uint_t n, cost_t* cost[], int_t* x, int_t* y)
+int lapjv_internal(const uint_t n, cost_t* cost[], int_t* x, int_t* y, uint_t* iterations)
 {
     int ret;
     int_t* free_rows;
@@ -336,11 +342,11 @@ int lapjv_internal(const uint_t n, cost_t* cost[], int_t* x, int_t* y)
     ret = _ccrrt_dense(n, cost, free_rows, x, y, v);
     int i = 0;
     while (ret > 0 && i < 2) {
-        ret = _carr_dense(n, cost, ret, free_rows, x, y, v);
+        ret = _carr_dense(n, cost, ret, free_rows, x, y, v, iterations);
         i++;
     }
     if (ret > 0) {
-        ret = _ca_dense(n, cost, ret, free_rows, x, y, v);
+        ret = _ca_dense(n, cost, ret, free_rows, x, y, v, iterations);
     }
     FREE(v);
     FREE(free_rows);
@@ -0,0 +1,181 @@
+#include "multiClassTracker.h"
+
+#include <future>
+#include <thread>
+
+namespace bytetrack {
+
+MultiClassTracker::MultiClassTracker(int frame_rate, int track_buffer, int parallel_min)
+  : frame_rate(frame_rate)
+  , track_buffer(track_buffer)
+  , parallel_min(parallel_min)
+  , parallel_frames(0)
+  , hardware_threads(std::thread::hardware_concurrency())
+  , timestamp_pending(false)
+  , next_timestamp(0)
+{
+}
+
+MultiClassTracker::~MultiClassTracker() {}
+
+MultiClassTracker::ClassTracker& MultiClassTracker::class_tracker(int label)
+{
+    std::map<int, size_t>::iterator it = class_index.find(label);
+    if (it != class_index.end())
+        return classes[it->second];
+
+    ClassTracker added;
+    added.label = label;
+    added.tracker.reset(new BYTETracker(frame_rate, track_buffer));
+    added.tracker->set_overload_config(overload_config);
+    if (timestamp_pending)
+        added.tracker->predict_next(next_timestamp);
+    size_t pos = 0;
+    while (pos < classes.size() && classes[pos].label < label)
+        pos++;
+    classes.insert(classes.begin() + pos, std::move(added));
+    for (size_t i = pos; i < classes.size(); i++)
+        class_index[classes[i].label] = i;
+    return classes[pos];
+}
+
+std::vector<STrack> MultiClassTracker::update(const std::vector<Object>& objects)
+{
+    return associate_and_update(objects);
+}
+
+std::vector<STrack> MultiClassTracker::update(const std::vector<Object>& objects,
+                                              double timestamp)
+{
+    predict_next(timestamp);
+    return associate_and_update(objects);
+}
+
+void MultiClassTracker::predict_next()
+{
+    for (size_t i = 0; i < classes.size(); i++)
+        classes[i].tracker->predict_next();
+}
+
+void MultiClassTracker::predict_next(double timestamp)
+{
+    timestamp_pending = true;
+    next_timestamp = timestamp;
+    for (size_t i = 0; i < classes.size(); i++)
+        classes[i].tracker->predict_next(timestamp);
+}
+
+std::vector<STrack> MultiClassTracker::associate_and_update(const std::vector<Object>& objects)
+{
+    for (size_t i = 0; i < classes.size(); i++)
+        classes[i].objects.clear();
+    // consecutive detections mostly share their label, after a per-class NMS
+    ClassTracker* last = nullptr;
+    for (size_t i = 0; i < objects.size(); i++) {
+        // a new class moves the ones after it in the vector, so only this one is held
+        if (last == nullptr || last->label != objects[i].label)
+            last = &class_tracker(objects[i].label);
+        last->objects.push_back(objects[i]);
+    }
+    timestamp_pending = false;
+
+    std::vector<size_t> large;
+    for (size_t i = 0; i < classes.size(); i++) {
+        const BYTETracker& tracker = *classes[i].tracker;
+        size_t population =
+          tracker.get_tracked_count() + tracker.get_lost_count() + classes[i].objects.size();
+        if ((int)population >= parallel_min)
+            large.push_back(i);
+    }
+
+    std::vector<std::future<void>> running;
+    std::vector<bool> on_thread(classes.size(), false);
+    if (large.size() >= 2 && hardware_threads > 1) {
+        parallel_frames++;
+        // the calling thread takes the first large class and all the small ones
+        for (size_t k = 1; k < large.size(); k++) {
+            ClassTracker* c = &classes[large[k]];
+            on_thread[large[k]] = true;
+            running.push_back(std::async(std::launch::async, [c]() {
+                c->output = c->tracker->associate_and_update(c->objects);
+            }));
+        }
+    }
+    for (size_t i = 0; i < classes.size(); i++) {
+        if (!on_thread[i])
+            classes[i].output = classes[i].tracker->associate_and_update(classes[i].objects);
+    }
+    for (size_t k = 0; k < running.size(); k++)
+        running[k].get();
+    return merge_output();
+}
+
+std::vector<STrack> MultiClassTracker::predict_only()
+{
+    for (size_t i = 0; i < classes.size(); i++)
+        classes[i].output = classes[i].tracker->predict_only();
+    timestamp_pending = false;
+    return merge_output();
+}
+
+std::vector<STrack> MultiClassTracker::predict_only(double timestamp)
+{
+    for (size_t i = 0; i < classes.size(); i++)
+        classes[i].output = classes[i].tracker->predict_only(timestamp);
+    timestamp_pending = false;
+    return merge_output();
+}
+
+std::vector<STrack> MultiClassTracker::merge_output()
+{
+    size_t total = 0;
+    for (size_t i = 0; i < classes.size(); i++)
+        total += classes[i].output.size();
+    std::vector<STrack> output;
+    output.reserve(total);
+    for (size_t i = 0; i < classes.size(); i++)
+        output.insert(output.end(), classes[i].output.begin(), classes[i].output.end());
+    return output;
+}
+
+void MultiClassTracker::set_overload_config(const OverloadConfig& config)
+{
+    overload_config = config;
+    for (size_t i = 0; i < classes.size(); i++)
+        classes[i].tracker->set_overload_config(config);
+}
+
+size_t MultiClassTracker::get_tracked_count() const
+{
+    size_t count = 0;
+    for (size_t i = 0; i < classes.size(); i++)
+        count += classes[i].tracker->get_tracked_count();
+    return count;
+}
+
+size_t MultiClassTracker::get_lost_count() const
+{
+    size_t count = 0;
+    for (size_t i = 0; i < classes.size(); i++)
+        count += classes[i].tracker->get_lost_count();
+    return count;
+}
+
+size_t MultiClassTracker::get_removed_count() const
+{
+    size_t count = 0;
+    for (size_t i = 0; i < classes.size(); i++)
+        count += classes[i].tracker->get_removed_count();
+    return count;
+}
+
+#ifdef BYTETRACK_PROFILE
+void MultiClassTracker::print_profiles(std::ostream& os) const
+{
+    for (size_t i = 0; i < classes.size(); i++) {
+        os << "class " << classes[i].label << std::endl;
+        classes[i].tracker->get_profile().print(os);
+    }
+}
+#endif
+}
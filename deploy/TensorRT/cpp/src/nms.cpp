@@ -0,0 +1,208 @@
+#include "nms.h"
+
+#include <algorithm>
+#include <numeric>
+
+namespace bytetrack {
+
+// Below this many candidates a linear scan of the kept boxes is faster than the grid.
+static const int GRID_MIN_BOXES = 256;
+// at most this many cells per side
+static const int MAX_GRID_CELLS = 32;
+// kept boxes compared per vectorized block before checking for a hit
+static const int IOU_BLOCK = 16;
+
+void NmsEngine::BoxSet::clear()
+{
+    x0.clear();
+    y0.clear();
+    x1.clear();
+    y1.clear();
+    area.clear();
+}
+
+void NmsEngine::BoxSet::push(float bx0, float by0, float bx1, float by1, float barea)
+{
+    x0.push_back(bx0);
+    y0.push_back(by0);
+    x1.push_back(bx1);
+    y1.push_back(by1);
+    area.push_back(barea);
+}
+
+// Same arithmetic as cv::Rect_<float>::operator& and the former nms_sorted_bboxes, so the
+// same boxes are kept.
+bool NmsEngine::BoxSet::overlaps(float bx0,
+                                 float by0,
+                                 float bx1,
+                                 float by1,
+                                 float barea,
+                                 float thresh) const
+{
+    const int n = x0.size();
+    for (int begin = 0; begin < n; begin += IOU_BLOCK) {
+        const int end = std::min(n, begin + IOU_BLOCK);
+        int hit = 0;
+        for (int j = begin; j < end; j++) {
+            float w = std::min(bx1, x1[j]) - std::max(bx0, x0[j]);
+            float h = std::min(by1, y1[j]) - std::max(by0, y0[j]);
+            float inter = std::max(w, 0.0f) * std::max(h, 0.0f);
+            hit |= inter / (barea + area[j] - inter) > thresh;
+        }
+        if (hit)
+            return true;
+    }
+    return false;
+}
+
+NmsEngine::NmsEngine(float iou_threshold, int top_k, bool per_class)
+  : iou_threshold(iou_threshold)
+  , top_k(top_k)
+  , per_class(per_class)
+  , grid_w(0)
+  , grid_h(0)
+  , grid_x0(0.0f)
+  , grid_y0(0.0f)
+  , inv_cell(1.0f)
+{}
+
+void NmsEngine::cell_range(int i, int& cx0, int& cy0, int& cx1, int& cy1) const
+{
+    cx0 = std::min(grid_w - 1, std::max(0, (int)((boxes.x0[i] - grid_x0) * inv_cell)));
+    cy0 = std::min(grid_h - 1, std::max(0, (int)((boxes.y0[i] - grid_y0) * inv_cell)));
+    cx1 = std::min(grid_w - 1, std::max(0, (int)((boxes.x1[i] - grid_x0) * inv_cell)));
+    cy1 = std::min(grid_h - 1, std::max(0, (int)((boxes.y1[i] - grid_y0) * inv_cell)));
+}
+
+// Greedy suppression over the positions [begin, end) of `boxes`, in that order.
+void NmsEngine::suppress(const int* begin, const int* end, std::vector<int>& out)
+{
+    if (end - begin < GRID_MIN_BOXES) {
+        kept.clear();
+        for (const int* p = begin; p != end; p++) {
+            const int i = *p;
+            if (kept.overlaps(boxes.x0[i],
+                              boxes.y0[i],
+                              boxes.x1[i],
+                              boxes.y1[i],
+                              boxes.area[i],
+                              iou_threshold))
+                continue;
+            kept.push(boxes.x0[i], boxes.y0[i], boxes.x1[i], boxes.y1[i], boxes.area[i]);
+            out.push_back(i);
+        }
+        return;
+    }
+
+    // cells about the size of an average box: two boxes that intersect share a cell, and
+    // most boxes cover only a few
+    float min_x = boxes.x0[*begin], min_y = boxes.y0[*begin];
+    float max_x = boxes.x1[*begin], max_y = boxes.y1[*begin];
+    double size_sum = 0.0;
+    for (const int* p = begin; p != end; p++) {
+        const int i = *p;
+        min_x = std::min(min_x, boxes.x0[i]);
+        min_y = std::min(min_y, boxes.y0[i]);
+        max_x = std::max(max_x, boxes.x1[i]);
+        max_y = std::max(max_y, boxes.y1[i]);
+        size_sum += std::max(boxes.x1[i] - boxes.x0[i], boxes.y1[i] - boxes.y0[i]);
+    }
+    float cell = size_sum / (end - begin);
+    cell = std::max(cell, std::max(max_x - min_x, max_y - min_y) / MAX_GRID_CELLS);
+    cell = std::max(cell, 1.0f);
+    grid_x0 = min_x;
+    grid_y0 = min_y;
+    inv_cell = 1.0f / cell;
+    grid_w = std::min(MAX_GRID_CELLS, (int)((max_x - min_x) * inv_cell) + 1);
+    grid_h = std::min(MAX_GRID_CELLS, (int)((max_y - min_y) * inv_cell) + 1);
+    if ((int)cells.size() < grid_w * grid_h)
+        cells.resize(grid_w * grid_h);
+    for (int c = 0; c < grid_w * grid_h; c++)
+        cells[c].clear();
+
+    for (const int* p = begin; p != end; p++) {
+        const int i = *p;
+        int cx0, cy0, cx1, cy1;
+        cell_range(i, cx0, cy0, cx1, cy1);
+        bool suppressed = false;
+        for (int cy = cy0; cy <= cy1 && !suppressed; cy++) {
+            for (int cx = cx0; cx <= cx1 && !suppressed; cx++) {
+                suppressed = cells[cy * grid_w + cx].overlaps(boxes.x0[i],
+                                                              boxes.y0[i],
+                                                              boxes.x1[i],
+                                                              boxes.y1[i],
+                                                              boxes.area[i],
+                                                              iou_threshold);
+            }
+        }
+        if (suppressed)
+            continue;
+        for (int cy = cy0; cy <= cy1; cy++) {
+            for (int cx = cx0; cx <= cx1; cx++) {
+                cells[cy * grid_w + cx].push(
+                  boxes.x0[i], boxes.y0[i], boxes.x1[i], boxes.y1[i], boxes.area[i]);
+            }
+        }
+        out.push_back(i);
+    }
+}
+
+void NmsEngine::run(const std::vector<Object>& proposals, std::vector<int>& picked)
+{
+    picked.clear();
+    const int n = proposals.size();
+    if (n == 0)
+        return;
+
+    order.resize(n);
+    std::iota(order.begin(), order.end(), 0);
+    auto by_score = [&](int a, int b) {
+        return proposals[a].prob > proposals[b].prob ||
+               (proposals[a].prob == proposals[b].prob && a < b);
+    };
+    if (top_k > 0 && n > top_k) {
+        std::partial_sort(order.begin(), order.begin() + top_k, order.end(), by_score);
+        order.resize(top_k);
+    } else {
+        std::sort(order.begin(), order.end(), by_score);
+    }
+
+    const int m = order.size();
+    boxes.clear();
+    labels.resize(m);
+    for (int k = 0; k < m; k++) {
+        const Object& obj = proposals[order[k]];
+        boxes.push(obj.rect.x,
+                   obj.rect.y,
+                   obj.rect.x + obj.rect.width,
+                   obj.rect.y + obj.rect.height,
+                   obj.rect.area());
+        labels[k] = obj.label;
+    }
+
+    class_order.resize(m);
+    std::iota(class_order.begin(), class_order.end(), 0);
+    kept_positions.clear();
+    if (!per_class) {
+        suppress(class_order.data(), class_order.data() + m, kept_positions);
+    } else {
+        // one batch per label, each still by descending score, merged back by score
+        std::stable_sort(class_order.begin(), class_order.end(), [&](int a, int b) {
+            return labels[a] < labels[b];
+        });
+        for (int begin = 0; begin < m;) {
+            int end = begin + 1;
+            while (end < m && labels[class_order[end]] == labels[class_order[begin]])
+                end++;
+            suppress(class_order.data() + begin, class_order.data() + end, kept_positions);
+            begin = end;
+        }
+        std::sort(kept_positions.begin(), kept_positions.end());
+    }
+
+    picked.resize(kept_positions.size());
+    for (size_t k = 0; k < kept_positions.size(); k++)
+        picked[k] = order[kept_positions[k]];
+}
+
+}
@@ -0,0 +1,135 @@
+#include "overloadGuard.h"
+
+#include <algorithm>
+
+namespace bytetrack {
+
+// weight of the latest frame in the running means of the costs
+static const double COST_SMOOTHING = 0.2;
+// largest ratio of a frame cost to the running mean taken into it
+static const double MAX_COST_JUMP = 2.0;
+
+const char* overload_level_name(int level)
+{
+    switch (level) {
+        case OVERLOAD_NONE:
+            return "none";
+        case OVERLOAD_CAPPED:
+            return "capped";
+        case OVERLOAD_GREEDY:
+            return "greedy";
+        case OVERLOAD_NO_LOW_SCORE:
+            return "no low score";
+        default:
+            return "?";
+    }
+}
+
+OverloadGuard::OverloadGuard(const OverloadConfig& config)
+  : config(config)
+  , ns_per_object(-1.0)
+  , pool(0)
+  , tracked(0)
+  , unconfirmed(0)
+  , high(0)
+  , low(0)
+  , level(OVERLOAD_NONE)
+{
+    this->config.max_detections = std::max(1, config.max_detections);
+    for (int i = 0; i < OVERLOAD_LEVEL_COUNT; i++)
+        ns_per_unit[i] = -1.0;
+}
+
+void OverloadGuard::capped(int level, int& high, int& low) const
+{
+    high = this->high;
+    low = this->low;
+    if (level >= OVERLOAD_CAPPED) {
+        high = std::min(high, config.max_detections);
+        low = std::min(low, config.max_detections - high);
+    }
+    if (level >= OVERLOAD_NO_LOW_SCORE)
+        low = 0;
+}
+
+static double assignment_units(int rows, int cols, bool greedy)
+{
+    if (rows == 0 || cols == 0)
+        return 0.0;
+    double units = (double)rows * cols;
+    if (!greedy)
+        units += (double)(rows + cols) * (rows + cols);
+    return units;
+}
+
+double OverloadGuard::association_units(int level) const
+{
+    int high, low;
+    capped(level, high, low);
+    bool greedy = level >= OVERLOAD_GREEDY;
+    // the matrices are bounded by the detections before matching, as the sizes after
+    // the first association are not known yet
+    return assignment_units(pool, high, greedy) + assignment_units(tracked, low, greedy) +
+           assignment_units(unconfirmed, high, greedy);
+}
+
+int OverloadGuard::objects(int level) const
+{
+    int high, low;
+    capped(level, high, low);
+    return pool + unconfirmed + high + low;
+}
+
+int OverloadGuard::choose(int pool,
+                          int tracked,
+                          int unconfirmed,
+                          int high,
+                          int low,
+                          float& estimated_ms)
+{
+    this->pool = pool;
+    this->tracked = tracked;
+    this->unconfirmed = unconfirmed;
+    this->high = high;
+    this->low = low;
+    this->level = OVERLOAD_NONE;
+    estimated_ms = 0.f;
+    // not before the costs of a full frame were measured once
+    if (!enabled() || ns_per_unit[OVERLOAD_NONE] < 0.0 || ns_per_object < 0.0)
+        return level;
+
+    double rate = 0.0;
+    for (level = OVERLOAD_NONE; level < OVERLOAD_LEVEL_COUNT; level++) {
+        // a level not run yet is taken to cost as much per unit as the one before
+        if (ns_per_unit[level] >= 0.0)
+            rate = ns_per_unit[level];
+        estimated_ms =
+          (float)((ns_per_object * objects(level) + rate * association_units(level)) / 1e6);
+        if (estimated_ms <= config.budget_ms)
+            return level;
+    }
+    level = OVERLOAD_NO_LOW_SCORE;
+    return level;
+}
+
+void OverloadGuard::observe(double association_ns, double other_ns)
+{
+    double units = association_units(level);
+    if (units > 0.0)
+        smooth(ns_per_unit[level], association_ns / units);
+    int n = objects(level);
+    if (n > 0)
+        smooth(ns_per_object, other_ns / n);
+}
+
+void OverloadGuard::smooth(double& mean, double value)
+{
+    if (mean < 0.0) {
+        mean = value;
+        return;
+    }
+    // a frame preempted or stalled on a page fault moves the mean by a bounded step only
+    value = std::min(std::max(value, mean / MAX_COST_JUMP), mean * MAX_COST_JUMP);
+    mean += COST_SMOOTHING * (value - mean);
+}
+}
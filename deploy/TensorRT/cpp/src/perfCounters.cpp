@@ -0,0 +1,174 @@
+#include "perfCounters.h"
+
+#include <cerrno>
+#include <cstring>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace bytetrack {
+
+const char* perf_event_name(int event)
+{
+    switch (event) {
+        case PERF_CYCLES:
+            return "cycles";
+        case PERF_INSTRUCTIONS:
+            return "instructions";
+        case PERF_L1D_MISSES:
+            return "L1D misses";
+        case PERF_LLC_MISSES:
+            return "LLC misses";
+        case PERF_BRANCH_MISSES:
+            return "branch misses";
+        default:
+            return "unknown";
+    }
+}
+
+PerfCounters::PerfCounters()
+  : leader(-1)
+  , num_slots(0)
+{
+    for (int i = 0; i < PERF_EVENT_COUNT; i++) {
+        fds[i] = -1;
+        slots[i] = -1;
+    }
+}
+
+PerfCounters::~PerfCounters()
+{
+    close();
+}
+
+unsigned PerfCounters::mask() const
+{
+    unsigned m = 0;
+    for (int i = 0; i < PERF_EVENT_COUNT; i++) {
+        if (slots[i] >= 0)
+            m |= 1u << i;
+    }
+    return m;
+}
+
+#ifdef __linux__
+
+static void event_config(int event, struct perf_event_attr& attr)
+{
+    switch (event) {
+        case PERF_CYCLES:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_CPU_CYCLES;
+            break;
+        case PERF_INSTRUCTIONS:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+            break;
+        case PERF_L1D_MISSES:
+            attr.type = PERF_TYPE_HW_CACHE;
+            attr.config = PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                          (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+            break;
+        case PERF_LLC_MISSES:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_CACHE_MISSES;
+            break;
+        default:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+            break;
+    }
+}
+
+bool PerfCounters::open()
+{
+    close();
+    for (int i = 0; i < PERF_EVENT_COUNT; i++) {
+        struct perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        event_config(i, attr);
+        attr.disabled = leader < 0 ? 1 : 0;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format =
+          PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+        int fd = (int)syscall(__NR_perf_event_open, &attr, 0, -1, leader, 0);
+        if (fd < 0) {
+            if (!error.empty())
+                error += "; ";
+            error += std::string(perf_event_name(i)) + ": " + strerror(errno);
+            continue;
+        }
+        fds[i] = fd;
+        slots[i] = num_slots++;
+        if (leader < 0)
+            leader = fd;
+    }
+    if (leader < 0)
+        return false;
+
+    ioctl(leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    return true;
+}
+
+void PerfCounters::close()
+{
+    for (int i = 0; i < PERF_EVENT_COUNT; i++) {
+        if (fds[i] >= 0)
+            ::close(fds[i]);
+        fds[i] = -1;
+        slots[i] = -1;
+    }
+    leader = -1;
+    num_slots = 0;
+    error.clear();
+}
+
+bool PerfCounters::read(PerfSample& sample) const
+{
+    memset(&sample, 0, sizeof(sample));
+    if (leader < 0)
+        return false;
+
+    // nr, time_enabled, time_running, then one value per group member
+    uint64_t buf[3 + PERF_EVENT_COUNT];
+    ssize_t size = ::read(leader, buf, sizeof(buf));
+    if (size < (ssize_t)(3 * sizeof(uint64_t)) || buf[0] != (uint64_t)num_slots)
+        return false;
+
+    double scale = 1.0;
+    if (buf[2] > 0 && buf[2] < buf[1])
+        scale = (double)buf[1] / buf[2];
+    for (int i = 0; i < PERF_EVENT_COUNT; i++) {
+        if (slots[i] >= 0)
+            sample.values[i] = (uint64_t)(buf[3 + slots[i]] * scale);
+    }
+    return true;
+}
+
+#else
+
+bool PerfCounters::open()
+{
+    error = "hardware counters need Linux perf_event_open";
+    return false;
+}
+
+void PerfCounters::close() {}
+
+bool PerfCounters::read(PerfSample& sample) const
+{
+    memset(&sample, 0, sizeof(sample));
+    return false;
+}
+
+#endif
+
+}
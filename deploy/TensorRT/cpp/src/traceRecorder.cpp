@@ -0,0 +1,130 @@
+#include "traceRecorder.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+
+namespace bytetrack {
+
+static const int MAX_TRACE_THREADS = 64;
+
+TraceRecorder::Event* TraceRecorder::events = nullptr;
+static size_t trace_capacity = 0;
+static std::atomic<uint64_t> trace_next(0);
+static std::atomic<uint32_t> trace_threads(0);
+static const char* trace_thread_names[MAX_TRACE_THREADS];
+static std::chrono::steady_clock::time_point trace_epoch;
+
+static thread_local int trace_frame = -1;
+static thread_local uint32_t trace_tid = 0; // 0 until the thread records its first event
+
+static uint32_t thread_tid()
+{
+    if (trace_tid == 0)
+        trace_tid = trace_threads.fetch_add(1, std::memory_order_relaxed) + 1;
+    return trace_tid;
+}
+
+bool TraceRecorder::start(size_t capacity)
+{
+    stop();
+    if (capacity == 0)
+        return false;
+    trace_epoch = std::chrono::steady_clock::now();
+    trace_next.store(0, std::memory_order_relaxed);
+    trace_capacity = capacity;
+    events = new Event[capacity];
+    return true;
+}
+
+void TraceRecorder::stop()
+{
+    delete[] events;
+    events = nullptr;
+    trace_capacity = 0;
+}
+
+int64_t TraceRecorder::now_ns()
+{
+    std::chrono::steady_clock::duration elapsed = std::chrono::steady_clock::now() - trace_epoch;
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+}
+
+void TraceRecorder::record(const char* name, int64_t begin_ns, int64_t end_ns)
+{
+    if (events == nullptr)
+        return;
+    uint64_t idx = trace_next.fetch_add(1, std::memory_order_relaxed);
+    Event& e = events[idx % trace_capacity];
+    e.name = name;
+    e.begin_ns = begin_ns;
+    e.end_ns = end_ns;
+    e.frame = trace_frame;
+    e.tid = thread_tid();
+}
+
+void TraceRecorder::set_frame(int frame)
+{
+    trace_frame = frame;
+}
+
+void TraceRecorder::set_thread_name(const char* name)
+{
+    uint32_t tid = thread_tid();
+    if (tid < MAX_TRACE_THREADS)
+        trace_thread_names[tid] = name;
+}
+
+bool TraceRecorder::dump(const std::string& path)
+{
+    if (events == nullptr)
+        return false;
+    FILE* file = fopen(path.c_str(), "w");
+    if (file == nullptr) {
+        std::cerr << "Cannot open trace " << path << " for writing" << std::endl;
+        return false;
+    }
+
+    uint64_t next = trace_next.load(std::memory_order_acquire);
+    uint64_t count = next < trace_capacity ? next : trace_capacity;
+    if (next > trace_capacity)
+        std::cerr << "Trace buffer wrapped, the first " << next - trace_capacity
+                  << " events were dropped" << std::endl;
+
+    fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    fprintf(file,
+            "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,"
+            "\"args\":{\"name\":\"bytetrack\"}}");
+    uint32_t num_threads = trace_threads.load(std::memory_order_relaxed);
+    for (uint32_t tid = 1; tid <= num_threads && tid < MAX_TRACE_THREADS; tid++) {
+        if (trace_thread_names[tid] == nullptr)
+            continue;
+        fprintf(file,
+                ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,"
+                "\"args\":{\"name\":\"%s\"}}",
+                tid,
+                trace_thread_names[tid]);
+    }
+    for (uint64_t i = next - count; i < next; i++) {
+        const Event& e = events[i % trace_capacity];
+        // timestamps in microseconds, as the format expects
+        fprintf(file,
+                ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f",
+                e.name,
+                e.tid,
+                e.begin_ns / 1000.0,
+                (e.end_ns - e.begin_ns) / 1000.0);
+        if (e.frame >= 0)
+            fprintf(file, ",\"args\":{\"frame\":%d}", e.frame);
+        fprintf(file, "}");
+    }
+    fprintf(file, "\n]}\n");
+    bool ok = ferror(file) == 0;
+    ok = fclose(file) == 0 && ok;
+    if (ok)
+        std::cout << "Wrote " << count << " trace events to " << path << std::endl;
+    return ok;
+}
+
+}
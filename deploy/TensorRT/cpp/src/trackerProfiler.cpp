@@ -0,0 +1,280 @@
+#include "trackerProfiler.h"
+
+#include <iomanip>
+
+namespace bytetrack {
+
+const char* stage_name(int stage)
+{
+    switch (stage) {
+        case STAGE_DETECTIONS:
+            return "detections";
+        case STAGE_FIRST_ASSOCIATION:
+            return "first_association";
+        case STAGE_SECOND_ASSOCIATION:
+            return "second_association";
+        case STAGE_UNCONFIRMED:
+            return "unconfirmed";
+        case STAGE_STATE_UPDATE:
+            return "state_update";
+        default:
+            return "unknown";
+    }
+}
+
+static void store_max(std::atomic<uint64_t>& target, uint64_t value)
+{
+    // only the owning tracker writes, so no compare-and-swap loop is needed
+    if (value > target.load(std::memory_order_relaxed))
+        target.store(value, std::memory_order_relaxed);
+}
+
+uint64_t HistogramSnapshot::percentile(double p) const
+{
+    if (count == 0)
+        return 0;
+    uint64_t rank = (uint64_t)(p / 100.0 * count + 0.5);
+    if (rank < 1)
+        rank = 1;
+    uint64_t seen = 0;
+    for (size_t i = 0; i < counts.size(); i++) {
+        seen += counts[i];
+        if (seen >= rank) {
+            uint64_t upper = LatencyHistogram::bucket_upper(i);
+            return upper < max ? upper : max;
+        }
+    }
+    return max;
+}
+
+LatencyHistogram::LatencyHistogram()
+{
+    reset();
+}
+
+int LatencyHistogram::bucket_index(uint64_t value)
+{
+    if (value < (1ULL << SUB_BITS))
+        return (int)value;
+    int msb = 63 - __builtin_clzll(value);
+    int shift = msb - SUB_BITS;
+    return ((shift + 1) << SUB_BITS) + (int)((value >> shift) - (1ULL << SUB_BITS));
+}
+
+uint64_t LatencyHistogram::bucket_upper(int index)
+{
+    if (index < (1 << SUB_BITS))
+        return index;
+    int shift = (index >> SUB_BITS) - 1;
+    uint64_t sub = index & ((1 << SUB_BITS) - 1);
+    uint64_t lower = ((1ULL << SUB_BITS) + sub) << shift;
+    return lower + ((1ULL << shift) - 1);
+}
+
+void LatencyHistogram::record(uint64_t value)
+{
+    counts[bucket_index(value)].fetch_add(1, std::memory_order_relaxed);
+    sum.fetch_add(value, std::memory_order_relaxed);
+    store_max(max, value);
+}
+
+HistogramSnapshot LatencyHistogram::snapshot() const
+{
+    HistogramSnapshot snap;
+    snap.counts.resize(NUM_BUCKETS);
+    snap.count = 0;
+    for (int i = 0; i < NUM_BUCKETS; i++) {
+        snap.counts[i] = counts[i].load(std::memory_order_relaxed);
+        snap.count += snap.counts[i];
+    }
+    snap.sum = sum.load(std::memory_order_relaxed);
+    snap.max = max.load(std::memory_order_relaxed);
+    return snap;
+}
+
+void LatencyHistogram::reset()
+{
+    for (int i = 0; i < NUM_BUCKETS; i++)
+        counts[i].store(0, std::memory_order_relaxed);
+    sum.store(0, std::memory_order_relaxed);
+    max.store(0, std::memory_order_relaxed);
+}
+
+TrackerProfiler::TrackerProfiler()
+  : current_stage(-1)
+  , perf(nullptr)
+{
+    reset();
+}
+
+void TrackerProfiler::record_assignment(int rows, int cols, uint64_t lap_iterations)
+{
+    if (current_stage < 0)
+        return;
+    AtomicAssociation& a = association[current_stage];
+    a.calls.fetch_add(1, std::memory_order_relaxed);
+    a.cells.fetch_add((uint64_t)rows * cols, std::memory_order_relaxed);
+    store_max(a.max_rows, rows);
+    store_max(a.max_cols, cols);
+    a.lap_iterations.fetch_add(lap_iterations, std::memory_order_relaxed);
+    store_max(a.max_lap_iterations, lap_iterations);
+}
+
+void TrackerProfiler::record_stage_allocs(int stage, const AllocCounters& delta)
+{
+    stage_allocs[stage].allocations.fetch_add(delta.allocations, std::memory_order_relaxed);
+    stage_allocs[stage].bytes.fetch_add(delta.bytes, std::memory_order_relaxed);
+}
+
+void TrackerProfiler::record_frame_allocs(const AllocCounters& delta)
+{
+    frame_allocs.record(delta.allocations);
+}
+
+void TrackerProfiler::record_stage_perf(int stage, const PerfSample& delta)
+{
+    for (int e = 0; e < PERF_EVENT_COUNT; e++)
+        stage_perf[stage][e].fetch_add(delta.values[e], std::memory_order_relaxed);
+}
+
+void TrackerProfiler::record_population(int tracked, int unconfirmed, int lost, int removed)
+{
+    population[0].store(tracked, std::memory_order_relaxed);
+    population[1].store(unconfirmed, std::memory_order_relaxed);
+    population[2].store(lost, std::memory_order_relaxed);
+    population[3].store(removed, std::memory_order_relaxed);
+}
+
+TrackerProfile TrackerProfiler::snapshot() const
+{
+    TrackerProfile profile;
+    profile.frame = frame.snapshot();
+    for (int s = 0; s < STAGE_COUNT; s++) {
+        profile.stages[s] = stages[s].snapshot();
+        const AtomicAssociation& a = association[s];
+        AssociationStats& stats = profile.association[s];
+        stats.calls = a.calls.load(std::memory_order_relaxed);
+        stats.cells = a.cells.load(std::memory_order_relaxed);
+        stats.max_rows = a.max_rows.load(std::memory_order_relaxed);
+        stats.max_cols = a.max_cols.load(std::memory_order_relaxed);
+        stats.lap_iterations = a.lap_iterations.load(std::memory_order_relaxed);
+        stats.max_lap_iterations = a.max_lap_iterations.load(std::memory_order_relaxed);
+        profile.allocs[s].allocations =
+          stage_allocs[s].allocations.load(std::memory_order_relaxed);
+        profile.allocs[s].bytes = stage_allocs[s].bytes.load(std::memory_order_relaxed);
+        for (int e = 0; e < PERF_EVENT_COUNT; e++)
+            profile.perf[s].values[e] = stage_perf[s][e].load(std::memory_order_relaxed);
+    }
+    profile.perf_mask = perf != nullptr ? perf->mask() : 0;
+    profile.frame_allocations = frame_allocs.snapshot();
+    profile.tracked = population[0].load(std::memory_order_relaxed);
+    profile.unconfirmed = population[1].load(std::memory_order_relaxed);
+    profile.lost = population[2].load(std::memory_order_relaxed);
+    profile.removed = population[3].load(std::memory_order_relaxed);
+    return profile;
+}
+
+void TrackerProfiler::reset()
+{
+    frame.reset();
+    for (int s = 0; s < STAGE_COUNT; s++) {
+        stages[s].reset();
+        AtomicAssociation& a = association[s];
+        a.calls.store(0, std::memory_order_relaxed);
+        a.cells.store(0, std::memory_order_relaxed);
+        a.max_rows.store(0, std::memory_order_relaxed);
+        a.max_cols.store(0, std::memory_order_relaxed);
+        a.lap_iterations.store(0, std::memory_order_relaxed);
+        a.max_lap_iterations.store(0, std::memory_order_relaxed);
+        stage_allocs[s].allocations.store(0, std::memory_order_relaxed);
+        stage_allocs[s].bytes.store(0, std::memory_order_relaxed);
+        for (int e = 0; e < PERF_EVENT_COUNT; e++)
+            stage_perf[s][e].store(0, std::memory_order_relaxed);
+    }
+    frame_allocs.reset();
+    record_population(0, 0, 0, 0);
+}
+
+static void print_histogram(std::ostream& os, const char* name, const HistogramSnapshot& h)
+{
+    os << std::left << std::setw(20) << name << std::right << std::fixed << std::setprecision(1)
+       << std::setw(10) << h.mean() / 1000.0 << std::setw(10) << h.percentile(50) / 1000.0
+       << std::setw(10) << h.percentile(90) / 1000.0 << std::setw(10)
+       << h.percentile(99) / 1000.0 << std::setw(10) << h.percentile(99.9) / 1000.0
+       << std::setw(10) << h.max / 1000.0 << std::endl;
+}
+
+void TrackerProfile::print(std::ostream& os) const
+{
+    std::ios::fmtflags flags = os.flags();
+    std::streamsize precision = os.precision();
+
+    os << std::left << std::setw(20) << "stage (us)" << std::right << std::setw(10) << "mean"
+       << std::setw(10) << "p50" << std::setw(10) << "p90" << std::setw(10) << "p99"
+       << std::setw(10) << "p99.9" << std::setw(10) << "max" << std::endl;
+    for (int s = 0; s < STAGE_COUNT; s++)
+        print_histogram(os, stage_name(s), stages[s]);
+    print_histogram(os, "update", frame);
+
+    os << std::endl
+       << std::left << std::setw(20) << "association" << std::right << std::setw(10) << "calls"
+       << std::setw(12) << "mean cells" << std::setw(10) << "max rows" << std::setw(10)
+       << "max cols" << std::setw(12) << "mean iters" << std::setw(10) << "max iters"
+       << std::endl;
+    for (int s = 0; s < STAGE_COUNT; s++) {
+        const AssociationStats& a = association[s];
+        if (a.calls == 0)
+            continue;
+        os << std::left << std::setw(20) << stage_name(s) << std::right << std::setw(10)
+           << a.calls << std::setw(12) << (double)a.cells / a.calls << std::setw(10)
+           << a.max_rows << std::setw(10) << a.max_cols << std::setw(12)
+           << (double)a.lap_iterations / a.calls << std::setw(10) << a.max_lap_iterations
+           << std::endl;
+    }
+
+    if (frame_allocations.count > 0) {
+        double frames = (double)frame_allocations.count;
+        os << std::endl
+           << std::left << std::setw(20) << "allocations/frame" << std::right << std::setw(10)
+           << "allocs" << std::setw(12) << "KB" << std::endl;
+        for (int s = 0; s < STAGE_COUNT; s++) {
+            os << std::left << std::setw(20) << stage_name(s) << std::right << std::setw(10)
+               << allocs[s].allocations / frames << std::setw(12)
+               << allocs[s].bytes / frames / 1024.0 << std::endl;
+        }
+        os << std::left << std::setw(20) << "update" << std::right << std::setw(10)
+           << frame_allocations.mean() << "  (p50 " << frame_allocations.percentile(50)
+           << ", p99 " << frame_allocations.percentile(99) << ", max " << frame_allocations.max
+           << ")" << std::endl;
+    }
+
+    if (perf_mask != 0) {
+        os << std::endl << std::left << std::setw(20) << "counters/frame" << std::right;
+        for (int e = 0; e < PERF_EVENT_COUNT; e++) {
+            if (perf_mask & (1u << e))
+                os << std::setw(15) << perf_event_name(e);
+        }
+        os << std::setw(8) << "IPC" << std::endl;
+        for (int s = 0; s < STAGE_COUNT; s++) {
+            double frames = stages[s].count > 0 ? (double)stages[s].count : 1.0;
+            os << std::left << std::setw(20) << stage_name(s) << std::right;
+            for (int e = 0; e < PERF_EVENT_COUNT; e++) {
+                if (perf_mask & (1u << e))
+                    os << std::setw(15) << perf[s].values[e] / frames;
+            }
+            const uint64_t* v = perf[s].values;
+            os << std::setprecision(2) << std::setw(8)
+               << (v[PERF_CYCLES] > 0 ? (double)v[PERF_INSTRUCTIONS] / v[PERF_CYCLES] : 0.0)
+               << std::setprecision(1) << std::endl;
+        }
+    }
+
+    os << std::endl
+       << "tracks: " << tracked << " tracked, " << unconfirmed << " unconfirmed, " << lost
+       << " lost, " << removed << " removed" << std::endl;
+
+    os.flags(flags);
+    os.precision(precision);
+}
+
+}
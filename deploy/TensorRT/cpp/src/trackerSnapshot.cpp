@@ -0,0 +1,147 @@
+#include "BYTETracker.h"
+#include "trackerSnapshot.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+namespace bytetrack {
+
+static void save_track(const STrack& track,
+                       const std::vector<int>& removed_ids,
+                       TrackerSnapshotTrack& record)
+{
+    record.track_id = track.track_id;
+    record.state = track.state;
+    record.label = track.label;
+    record.is_activated = track.is_activated;
+    record.frame_id = track.frame_id;
+    record.tracklet_len = track.tracklet_len;
+    record.start_frame = track.start_frame;
+    record.removed = std::binary_search(removed_ids.begin(), removed_ids.end(), track.track_id);
+    record.reserved = 0;
+    record.score = track.score;
+    record.timestamp = track.timestamp;
+    for (int i = 0; i < 4; i++) {
+        record.tlwh[i] = track.tlwh[i];
+        record.detection_tlwh[i] = track._tlwh[i];
+    }
+    memcpy(record.mean, track.mean.data(), sizeof(record.mean));
+    memcpy(record.covariance, track.covariance.data(), sizeof(record.covariance));
+}
+
+// into a track built from record.detection_tlwh
+static void load_track(const TrackerSnapshotTrack& record, STrack& track)
+{
+    track.track_id = record.track_id;
+    track.state = record.state;
+    track.label = record.label;
+    track.is_activated = record.is_activated != 0;
+    track.frame_id = record.frame_id;
+    track.tracklet_len = record.tracklet_len;
+    track.start_frame = record.start_frame;
+    track.timestamp = record.timestamp;
+    memcpy(track.mean.data(), record.mean, sizeof(record.mean));
+    memcpy(track.covariance.data(), record.covariance, sizeof(record.covariance));
+    // not static_tlwh(): a lost track keeps its last box while its mean moves on
+    track.tlwh.assign(record.tlwh, record.tlwh + 4);
+    track.static_tlbr();
+}
+
+void BYTETracker::save(std::vector<uint8_t>& buffer) const
+{
+    TrackerSnapshotHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, TRACKER_SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.version = TRACKER_SNAPSHOT_VERSION;
+    header.frame_id = this->frame_id;
+    header.last_id = STrack::last_id();
+    header.timed = this->timed;
+    header.num_tracked = (uint32_t)this->tracked_stracks.size();
+    header.num_lost = (uint32_t)this->lost_stracks.size();
+    header.timestamp = this->timestamp;
+
+    buffer.resize(sizeof(header) +
+                  (header.num_tracked + header.num_lost) * sizeof(TrackerSnapshotTrack));
+    memcpy(buffer.data(), &header, sizeof(header));
+
+    // removed_stracks only matters by the ids it shares with the saved tracks
+    std::vector<int> saved_ids, removed_ids;
+    saved_ids.reserve(header.num_tracked + header.num_lost);
+    for (size_t i = 0; i < this->tracked_stracks.size(); i++)
+        saved_ids.push_back(this->tracked_stracks[i].track_id);
+    for (size_t i = 0; i < this->lost_stracks.size(); i++)
+        saved_ids.push_back(this->lost_stracks[i].track_id);
+    std::sort(saved_ids.begin(), saved_ids.end());
+    for (size_t i = 0; i < this->removed_stracks.size(); i++) {
+        int id = this->removed_stracks[i].track_id;
+        if (std::binary_search(saved_ids.begin(), saved_ids.end(), id))
+            removed_ids.push_back(id);
+    }
+    std::sort(removed_ids.begin(), removed_ids.end());
+
+    TrackerSnapshotTrack* records = (TrackerSnapshotTrack*)(buffer.data() + sizeof(header));
+    for (size_t i = 0; i < this->tracked_stracks.size(); i++)
+        save_track(this->tracked_stracks[i], removed_ids, *records++);
+    for (size_t i = 0; i < this->lost_stracks.size(); i++)
+        save_track(this->lost_stracks[i], removed_ids, *records++);
+}
+
+bool BYTETracker::load(const uint8_t* data, size_t size)
+{
+    TrackerSnapshotHeader header;
+    if (size < sizeof(header)) {
+        std::cerr << "Tracker snapshot is truncated" << std::endl;
+        return false;
+    }
+    memcpy(&header, data, sizeof(header));
+    if (memcmp(header.magic, TRACKER_SNAPSHOT_MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != TRACKER_SNAPSHOT_VERSION) {
+        std::cerr << "Not a version " << TRACKER_SNAPSHOT_VERSION << " tracker snapshot"
+                  << std::endl;
+        return false;
+    }
+    size_t num_tracks = (size_t)header.num_tracked + header.num_lost;
+    if (size != sizeof(header) + num_tracks * sizeof(TrackerSnapshotTrack)) {
+        std::cerr << "Tracker snapshot is truncated" << std::endl;
+        return false;
+    }
+
+    // the records may not be aligned in the caller's buffer, so each one is copied out
+    const uint8_t* records = data + sizeof(header);
+    TrackerSnapshotTrack record;
+    std::vector<float> detection_tlwh;
+    this->tracked_stracks.clear();
+    this->lost_stracks.clear();
+    this->removed_stracks.clear();
+    this->tracked_stracks.reserve(header.num_tracked);
+    this->lost_stracks.reserve(header.num_lost);
+    for (size_t i = 0; i < num_tracks; i++) {
+        memcpy(&record, records + i * sizeof(record), sizeof(record));
+        std::vector<STrack>& list =
+          i < header.num_tracked ? this->tracked_stracks : this->lost_stracks;
+        detection_tlwh.assign(record.detection_tlwh, record.detection_tlwh + 4);
+        list.emplace_back(detection_tlwh, record.score);
+        load_track(record, list.back());
+        if (record.removed)
+            this->removed_stracks.push_back(list.back());
+    }
+
+    this->frame_id = header.frame_id;
+    this->timed = header.timed != 0;
+    this->timestamp = header.timestamp;
+    this->next_timestamp = header.timestamp;
+    this->next_dt = 1.f;
+    this->clock_advanced = false;
+    this->predicted = false;
+    this->unconfirmed_pool.clear();
+    this->strack_pool.clear();
+    STrack::reserve_ids(header.last_id);
+    return true;
+}
+
+bool BYTETracker::load(const std::vector<uint8_t>& buffer)
+{
+    return load(buffer.data(), buffer.size());
+}
+}
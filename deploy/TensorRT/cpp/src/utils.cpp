@@ -1,6 +1,11 @@
 #include "BYTETracker.h"
 #include "lapjv.h"
 
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+
 namespace bytetrack {
 
 std::vector<STrack*> BYTETracker::joint_stracks(std::vector<STrack*>& tlista,
@@ -143,6 +148,48 @@ void BYTETracker::linear_assignment(std::vector<std::vector<float>>& cost_matrix
     }
 }
 
+void BYTETracker::greedy_assignment(std::vector<std::vector<float>>& cost_matrix,
+                                    int cost_matrix_size,
+                                    int cost_matrix_size_size,
+                                    float thresh,
+                                    std::vector<std::vector<int>>& matches,
+                                    std::vector<int>& unmatched_a,
+                                    std::vector<int>& unmatched_b)
+{
+    std::vector<std::pair<float, int>> pairs;
+    for (size_t i = 0; i < cost_matrix.size(); i++) {
+        for (size_t j = 0; j < cost_matrix[i].size(); j++) {
+            if (cost_matrix[i][j] < thresh) {
+                int cell = (int)(i * cost_matrix_size_size + j);
+                pairs.push_back(std::make_pair(cost_matrix[i][j], cell));
+            }
+        }
+    }
+    std::sort(pairs.begin(), pairs.end());
+
+    std::vector<bool> used_a(cost_matrix_size, false), used_b(cost_matrix_size_size, false);
+    for (size_t k = 0; k < pairs.size(); k++) {
+        int i = pairs[k].second / cost_matrix_size_size;
+        int j = pairs[k].second % cost_matrix_size_size;
+        if (used_a[i] || used_b[j])
+            continue;
+        used_a[i] = used_b[j] = true;
+        std::vector<int> match;
+        match.push_back(i);
+        match.push_back(j);
+        matches.push_back(match);
+    }
+
+    for (int i = 0; i < cost_matrix_size; i++) {
+        if (!used_a[i])
+            unmatched_a.push_back(i);
+    }
+    for (int i = 0; i < cost_matrix_size_size; i++) {
+        if (!used_b[i])
+            unmatched_b.push_back(i);
+    }
+}
+
 std::vector<std::vector<float>> BYTETracker::ious(std::vector<std::vector<float>>& atlbrs,
                                                   std::vector<std::vector<float>>& btlbrs)
 {
@@ -325,7 +372,9 @@ double BYTETracker::lapjv(const std::vector<std::vector<float>>& cost,
     int* x_c = new int[sizeof(int) * n];
     int* y_c = new int[sizeof(int) * n];
 
-    int ret = lapjv_internal(n, cost_ptr, x_c, y_c);
+    uint_t iterations = 0;
+    int ret = lapjv_internal(n, cost_ptr, x_c, y_c, &iterations);
+    BYTETRACK_PROFILE_ASSIGNMENT(n_rows, n_cols, iterations);
     if (ret != 0) {
         std::cout << "Calculate Wrong!" << std::endl;
         system("pause");
@@ -0,0 +1,125 @@
+import argparse
+import configparser
+import os
+import re
+import subprocess
+import sys
+
+import motmetrics as mm
+
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), "../../../.."))
+from yolox.evaluators.evaluation import Evaluator
+
+
+def make_parser():
+    parser = argparse.ArgumentParser("detection cadence report")
+    parser.add_argument(
+        "-b",
+        "--binary",
+        type=str,
+        default="./bytetrack_replay",
+        help="The replay tool.",
+    )
+    parser.add_argument(
+        "-r",
+        "--records",
+        type=str,
+        default="records",
+        help="Directory with a <seq>.btdr detection record of every sequence, made by running a "
+        "demo with -r on <seq>/img1/%%06d.jpg.",
+    )
+    parser.add_argument(
+        "-d",
+        "--data_root",
+        type=str,
+        default="datasets/mot/train",
+        help="MOT challenge split with <seq>/gt/gt.txt and <seq>/seqinfo.ini, whose frameRate is "
+        "passed to the replay.",
+    )
+    parser.add_argument(
+        "-s",
+        "--seqs",
+        type=str,
+        nargs="+",
+        default=["MOT17-02-FRCNN", "MOT17-04-FRCNN", "MOT17-09-FRCNN"],
+        help="Sequences to run.",
+    )
+    parser.add_argument(
+        "-c",
+        "--cadences",
+        type=str,
+        nargs="+",
+        default=["1", "2", "3", "4", "auto"],
+        help="bytetrack_replay --cadence values to compare.",
+    )
+    parser.add_argument(
+        "--detector_ms",
+        type=float,
+        default=30.0,
+        help="Time of a detected frame (letterbox, inference, decoding), e.g. from the stage "
+        "times a demo prints.",
+    )
+    parser.add_argument(
+        "-o",
+        "--output_dir",
+        type=str,
+        default="cadence_report",
+        help="Where the MOT result files of every cadence go.",
+    )
+    parser.add_argument(
+        "--args",
+        type=str,
+        default="",
+        help="Extra replay options, e.g. \"--budget-ms 33 --max-interval 3\".",
+    )
+    return parser
+
+
+def seq_frame_rate(data_root, seq):
+    # the record of an image sequence holds whatever rate the video backend reported for it
+    info = configparser.ConfigParser()
+    info.read(os.path.join(data_root, seq, "seqinfo.ini"))
+    return info.getint("Sequence", "frameRate", fallback=30)
+
+
+def run_replay(args, seq, cadence):
+    result = os.path.join(args.output_dir, cadence, seq + ".txt")
+    os.makedirs(os.path.dirname(result), exist_ok=True)
+    cmd = [args.binary, os.path.join(args.records, seq + ".btdr"), "-o", result, "--cadence", cadence,
+           "--detector-ms", str(args.detector_ms), "--fps", str(seq_frame_rate(args.data_root, seq))]
+    cmd += args.args.split()
+    out = subprocess.run(cmd, stdout=subprocess.PIPE, universal_newlines=True, check=True).stdout
+    frames = int(re.search(r"^frames:\s+(\d+)", out, re.MULTILINE).group(1))
+    detected = re.search(r"^detections:\s+(\d+)", out, re.MULTILINE)
+    fps = re.search(r"detector: ([\d.]+) frames/s", out)
+    return result, frames, int(detected.group(1)) if detected else frames, float(fps.group(1))
+
+
+def main(args):
+    rows = []
+    for cadence in args.cadences:
+        accs, frames, detected, seconds = [], 0, 0, 0.0
+        for seq in args.seqs:
+            result, seq_frames, seq_detected, seq_fps = run_replay(args, seq, cadence)
+            accs.append(Evaluator(args.data_root, seq, "mot").eval_file(result))
+            frames += seq_frames
+            detected += seq_detected
+            seconds += seq_frames / seq_fps
+            print("cadence {} {}: {} of {} frames detected, {:.1f} FPS".format(
+                cadence, seq, seq_detected, seq_frames, seq_fps))
+        summary = Evaluator.get_summary(accs, args.seqs, ("mota", "idf1", "num_switches"))
+        print(mm.io.render_summary(summary, formatters=mm.metrics.create().formatters,
+                                   namemap=mm.io.motchallenge_metric_names))
+        overall = summary.loc["OVERALL"]
+        rows.append((cadence, overall["mota"], overall["idf1"], int(overall["num_switches"]),
+                     frames / detected, frames / seconds))
+
+    print("\nwith a {:.1f} ms detector".format(args.detector_ms))
+    print("cadence    MOTA    IDF1   IDs  interval    FPS")
+    for cadence, mota, idf1, switches, interval, fps in rows:
+        print("{:<7} {:6.1f}% {:6.1f}% {:5d} {:9.2f} {:6.1f}".format(
+            cadence, mota * 100, idf1 * 100, switches, interval, fps))
+
+
+if __name__ == "__main__":
+    main(make_parser().parse_args())
@@ -0,0 +1,93 @@
+#include "crowdGenerator.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+// Writes a synthetic crowd scenario to a .btdr detection record for bytetrack_replay.
+
+static void usage(const char* prog)
+{
+    std::cerr << "Usage: " << prog << " <out.btdr> [options]" << std::endl;
+    std::cerr << "  -p <preset>      default, stadium, drones or particles" << std::endl;
+    std::cerr << "  -n <objects>     objects in the scene (2000)" << std::endl;
+    std::cerr << "  -f <frames>      frames to generate (1000)" << std::endl;
+    std::cerr << "  -s <seed>        random seed (1)" << std::endl;
+    std::cerr << "  -d <dropout>     missed detection rate" << std::endl;
+    std::cerr << "  -o <occlusion>   occlusion rate" << std::endl;
+    std::cerr << "  -fp <count>      mean false positives per frame" << std::endl;
+    std::cerr << "  -v <speed>       mean speed in pixels per frame" << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 2) {
+        usage(argv[0]);
+        return -1;
+    }
+
+    std::string out_path = argv[1];
+    std::string preset = "default";
+    int num_objects = 2000;
+    int num_frames = 1000;
+    // overrides are applied on top of the preset
+    float dropout = -1.f, occlusion = -1.f, false_positives = -1.f, speed = -1.f;
+    unsigned long long seed = 1;
+    for (int i = 2; i < argc; i++) {
+        if (i + 1 >= argc) {
+            usage(argv[0]);
+            return -1;
+        }
+        if (!strcmp(argv[i], "-p")) {
+            preset = argv[++i];
+        } else if (!strcmp(argv[i], "-n")) {
+            num_objects = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "-f")) {
+            num_frames = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "-s")) {
+            seed = strtoull(argv[++i], nullptr, 10);
+        } else if (!strcmp(argv[i], "-d")) {
+            dropout = atof(argv[++i]);
+        } else if (!strcmp(argv[i], "-o")) {
+            occlusion = atof(argv[++i]);
+        } else if (!strcmp(argv[i], "-fp")) {
+            false_positives = atof(argv[++i]);
+        } else if (!strcmp(argv[i], "-v")) {
+            speed = atof(argv[++i]);
+        } else {
+            usage(argv[0]);
+            return -1;
+        }
+    }
+
+    bytetrack::CrowdConfig config;
+    if (preset == "stadium") {
+        config = bytetrack::CrowdConfig::stadium(num_objects);
+    } else if (preset == "drones") {
+        config = bytetrack::CrowdConfig::drone_swarm(num_objects);
+    } else if (preset == "particles") {
+        config = bytetrack::CrowdConfig::particles(num_objects);
+    } else if (preset == "default") {
+        config.num_objects = num_objects;
+    } else {
+        usage(argv[0]);
+        return -1;
+    }
+    config.seed = seed;
+    if (dropout >= 0.f)
+        config.dropout = dropout;
+    if (occlusion >= 0.f)
+        config.occlusion_rate = occlusion;
+    if (false_positives >= 0.f)
+        config.false_positives = false_positives;
+    if (speed >= 0.f)
+        config.speed_mean = speed;
+
+    bytetrack::CrowdGenerator generator(config);
+    if (!generator.write_record(out_path, num_frames))
+        return -1;
+    std::cout << "Wrote " << num_frames << " frames of " << num_objects << " " << preset
+              << " objects to " << out_path << std::endl;
+    return 0;
+}
@@ -0,0 +1,147 @@
+#include "letterbox.h"
+
+#include <opencv2/opencv.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+// Checks LetterboxPreprocessor against the previous preprocessing of the YOLOX demo
+// (cv::resize into a padded canvas, then cvtColor and a per-pixel normalization loop) on
+// an image or a synthetic frame, and times both.
+
+static const int INPUT_W = 1088;
+static const int INPUT_H = 608;
+static const float MEAN[3] = { 0.485f, 0.456f, 0.406f };
+static const float STD[3] = { 0.229f, 0.224f, 0.225f };
+
+static void usage(const char* prog)
+{
+    std::cerr << "Usage: " << prog << " [image] [options]" << std::endl;
+    std::cerr << "  -s <w>x<h>       size of the synthetic frame used without an image (1920x1080)"
+              << std::endl;
+    std::cerr << "  -t <threads>     worker threads of the fused kernel (1)" << std::endl;
+    std::cerr << "  -n <iterations>  timed runs of each version (100)" << std::endl;
+}
+
+static cv::Mat reference_resize(cv::Mat& img)
+{
+    float r = std::min(INPUT_W / (img.cols * 1.0), INPUT_H / (img.rows * 1.0));
+    int unpad_w = r * img.cols;
+    int unpad_h = r * img.rows;
+    cv::Mat re(unpad_h, unpad_w, CV_8UC3);
+    cv::resize(img, re, re.size());
+    cv::Mat out(INPUT_H, INPUT_W, CV_8UC3, cv::Scalar(114, 114, 114));
+    re.copyTo(out(cv::Rect(0, 0, re.cols, re.rows)));
+    return out;
+}
+
+static float* reference_blob(cv::Mat& img)
+{
+    cv::cvtColor(img, img, cv::COLOR_BGR2RGB);
+
+    float* blob = new float[img.total() * 3];
+    for (int c = 0; c < 3; c++) {
+        for (int h = 0; h < img.rows; h++) {
+            for (int w = 0; w < img.cols; w++) {
+                blob[c * img.cols * img.rows + h * img.cols + w] =
+                  (((float)img.at<cv::Vec3b>(h, w)[c]) / 255.0f - MEAN[c]) / STD[c];
+            }
+        }
+    }
+    return blob;
+}
+
+// A noisy gradient with some structure, so that the interpolation weights matter.
+static cv::Mat synthetic_frame(int width, int height)
+{
+    cv::Mat img(height, width, CV_8UC3);
+    cv::RNG rng(1);
+    for (int y = 0; y < height; y++) {
+        cv::Vec3b* row = img.ptr<cv::Vec3b>(y);
+        for (int x = 0; x < width; x++) {
+            for (int c = 0; c < 3; c++) {
+                int v = (x * (c + 1) / 7 + y * (3 - c) / 5 + ((x / 16 + y / 16) % 2) * 60) % 256;
+                row[x][c] = cv::saturate_cast<uchar>(v + rng.uniform(-16, 17));
+            }
+        }
+    }
+    return img;
+}
+
+int main(int argc, char** argv)
+{
+    std::string image_path;
+    int width = 1920, height = 1080;
+    int threads = 1;
+    int iterations = 100;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-s") && i + 1 < argc) {
+            if (sscanf(argv[++i], "%dx%d", &width, &height) != 2 || width <= 0 || height <= 0) {
+                usage(argv[0]);
+                return -1;
+            }
+        } else if (!strcmp(argv[i], "-t") && i + 1 < argc) {
+            threads = std::max(1, atoi(argv[++i]));
+        } else if (!strcmp(argv[i], "-n") && i + 1 < argc) {
+            iterations = std::max(1, atoi(argv[++i]));
+        } else if (argv[i][0] != '-' && image_path.empty()) {
+            image_path = argv[i];
+        } else {
+            usage(argv[0]);
+            return -1;
+        }
+    }
+
+    cv::Mat img = image_path.empty() ? synthetic_frame(width, height) : cv::imread(image_path);
+    if (img.empty()) {
+        std::cerr << "Cannot read " << image_path << std::endl;
+        return -1;
+    }
+
+    cv::Mat padded = reference_resize(img);
+    float* expected = reference_blob(padded);
+    bytetrack::LetterboxPreprocessor letterbox(INPUT_W, INPUT_H, MEAN, STD);
+    letterbox.run(img, threads);
+
+    // differences in gray levels of the resized image, i.e. undoing the normalization
+    const float* actual = letterbox.data();
+    const size_t plane = (size_t)INPUT_W * INPUT_H;
+    double max_levels = 0.0;
+    size_t mismatches = 0;
+    for (size_t i = 0; i < letterbox.size(); i++) {
+        double levels = std::fabs(actual[i] - expected[i]) * 255.0 * STD[i / plane];
+        max_levels = std::max(max_levels, levels);
+        if (levels >= 0.5)
+            mismatches++;
+    }
+    delete[] expected;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        cv::Mat pr_img = reference_resize(img);
+        float* blob = reference_blob(pr_img);
+        delete[] blob;
+    }
+    auto middle = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++)
+        letterbox.run(img, threads);
+    auto end = std::chrono::steady_clock::now();
+
+    printf("input:      %dx%d -> %dx%d\n", img.cols, img.rows, INPUT_W, INPUT_H);
+    printf("difference: max %.3f gray levels, %zu of %zu values off by half a level or more\n",
+           max_levels,
+           mismatches,
+           letterbox.size());
+    printf("reference:  %.3f ms\n",
+           std::chrono::duration<double, std::milli>(middle - start).count() / iterations);
+    printf("fused:      %.3f ms (%d thread%s)\n",
+           std::chrono::duration<double, std::milli>(end - middle).count() / iterations,
+           threads,
+           threads > 1 ? "s" : "");
+    return max_levels > 1.0 ? 1 : 0;
+}
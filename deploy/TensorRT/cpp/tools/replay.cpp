@@ -0,0 +1,657 @@
+#include "BYTETracker.h"
+#include "allocCounter.h"
+#include "cadenceController.h"
+#include "detRecord.h"
+#include "multiClassTracker.h"
+#include "perfCounters.h"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+// Replays a recorded detection stream through BYTETracker::update() as fast as possible.
+// Only the update() call is timed, so the numbers are free of decode, inference and drawing.
+// With --split the Kalman prediction runs before the clock starts, which leaves the part of
+// update() that has to wait for the detections.
+// With --cadence the detections of only some frames are used and the tracker carries the
+// tracks through the others with predict_only(), as a pipeline that skips the detector would.
+// With --drop some frames never reach the tracker, as when a loaded pipeline sheds frames;
+// --timestamps passes the time of each frame, so the tracker predicts over the gaps.
+// With --update-budget-ms the tracker degrades the frames it predicts to overrun the budget,
+// and the frames of each level are counted.
+// With --snapshot-every the tracker is saved every n frames and replaced by a new one
+// loaded from the snapshot, as a worker that fails over would be.
+// With --multi-class every label of the record gets its own tracker, in a MultiClassTracker.
+
+static void usage(const char* prog)
+{
+    std::cerr << "Usage: " << prog << " <detections.btdr> [options]" << std::endl;
+    std::cerr << "  -n <passes>       replay the stream n times, each with a fresh tracker (1)"
+              << std::endl;
+    std::cerr << "  -b <track_buffer> tracker track_buffer (30)" << std::endl;
+    std::cerr << "  -o <tracks.txt>   write the tracks of the last pass in MOT format" << std::endl;
+    std::cerr << "  --fps <rate>      frame rate of the stream, instead of the one recorded, which"
+              << std::endl;
+    std::cerr << "                    is wrong for image sequences (the recorded one, or 30)"
+              << std::endl;
+    std::cerr << "  --alloc-budget <n> allocations allowed per steady-state frame (0)" << std::endl;
+    std::cerr << "  --warmup <frames> frames per pass excluded from the steady state (100)"
+              << std::endl;
+    std::cerr << "  --perf            count cycles, instructions, cache and branch misses"
+              << std::endl;
+    std::cerr << "  --split           predict untimed before each frame, as a pipeline would, and"
+              << std::endl;
+    std::cerr << "                    time only associate_and_update()" << std::endl;
+    std::cerr << "  --cadence <n|auto> use the detections of every n-th frame, or of the frames a"
+              << std::endl;
+    std::cerr << "                    CadenceController picks, and predict the others (1)"
+              << std::endl;
+    std::cerr << "  --max-interval <n> longest auto cadence interval (4)" << std::endl;
+    std::cerr << "  --budget-ms <ms>  frame time the auto cadence keeps within (none)" << std::endl;
+    std::cerr << "  --detector-ms <ms> detector time per detected frame, added to the frame time"
+              << std::endl;
+    std::cerr << "                    seen by the cadence and to the throughput estimate (0)"
+              << std::endl;
+    std::cerr << "  --drop <fraction> drop that fraction of the frames at random (0)" << std::endl;
+    std::cerr << "  --timestamps      pass the frame times to the tracker, so it predicts over"
+              << std::endl;
+    std::cerr << "                    dropped frames and ages the lost tracks by time" << std::endl;
+    std::cerr << "  --update-budget-ms <ms> latency budget of associate_and_update() (none)"
+              << std::endl;
+    std::cerr << "  --max-detections <n> detections kept by score on overloaded frames (200)"
+              << std::endl;
+    std::cerr << "  --multi-class     track every label apart with a MultiClassTracker" << std::endl;
+    std::cerr << "  --parallel-min <n> tracks and detections of a class for it to run on a"
+              << std::endl;
+    std::cerr << "                    thread of its own, with --multi-class (100)" << std::endl;
+    std::cerr << "  --snapshot-every <frames> hand the tracks over to a new tracker through a"
+              << std::endl;
+    std::cerr << "                    snapshot every that many frames" << std::endl;
+    std::cerr << "  --soak <frames>   loop the stream through one tracker for that many frames"
+              << std::endl;
+    std::cerr << "  --soak-window <frames> frames per soak report line (10000)" << std::endl;
+    std::cerr << "  --soak-tolerance <f>   allowed growth of a soak metric over the run (0.1)"
+              << std::endl;
+}
+
+static double percentile(const std::vector<int64_t>& sorted_ns, double p)
+{
+    if (sorted_ns.empty())
+        return 0.0;
+    size_t idx = std::min(sorted_ns.size() - 1, (size_t)(p / 100.0 * sorted_ns.size()));
+    return sorted_ns[idx] / 1000.0;
+}
+
+// Resident set size in bytes; 0 where /proc is not available.
+static uint64_t resident_bytes()
+{
+    FILE* file = fopen("/proc/self/statm", "r");
+    if (file == nullptr)
+        return 0;
+    unsigned long long size = 0, resident = 0;
+    int n = fscanf(file, "%llu %llu", &size, &resident);
+    fclose(file);
+    return n == 2 ? resident * (uint64_t)sysconf(_SC_PAGESIZE) : 0;
+}
+
+// Growth of a series over the run relative to its mean, from a least-squares line through
+// the windows. The first tenth of the windows is left out as warm-up.
+static double relative_trend(const std::vector<double>& series)
+{
+    size_t skip = series.size() >= 10 ? series.size() / 10 : 0;
+    size_t n = series.size() - skip;
+    if (n < 3)
+        return 0.0;
+    double mean_x = (n - 1) / 2.0, mean_y = 0.0;
+    for (size_t i = skip; i < series.size(); i++)
+        mean_y += series[i] / n;
+    double sxy = 0.0, sxx = 0.0;
+    for (size_t i = 0; i < n; i++) {
+        sxy += (i - mean_x) * (series[skip + i] - mean_y);
+        sxx += (i - mean_x) * (i - mean_x);
+    }
+    return sxy / sxx * (n - 1) / std::max(std::fabs(mean_y), 1.0);
+}
+
+// Feeds the stream to a single tracker over and over, so the tracker sees one endless
+// sequence of frames, and watches latency, memory and list sizes for drift.
+static int run_soak(const bytetrack::DetRecordReader& reader,
+                    int frame_rate,
+                    int track_buffer,
+                    uint64_t soak_frames,
+                    size_t window,
+                    double tolerance)
+{
+    const size_t num_frames = reader.num_frames();
+    bytetrack::BYTETracker tracker(frame_rate, track_buffer);
+    std::vector<bytetrack::Object> objects;
+    std::vector<int64_t> latencies_ns;
+    latencies_ns.reserve(window);
+
+    const char* names[] = { "p50 us", "p99 us", "RSS MB", "tracked", "lost", "removed" };
+    const int num_series = sizeof(names) / sizeof(names[0]);
+    std::vector<double> series[num_series];
+    int max_id = 0;
+
+    printf("%12s %10s %10s %10s %10s %10s %10s %12s\n",
+           "frames",
+           names[0],
+           names[1],
+           names[2],
+           names[3],
+           names[4],
+           names[5],
+           "max id");
+    for (uint64_t frame = 0; frame < soak_frames; frame++) {
+        reader.get_frame(frame % num_frames, objects);
+
+        auto start = std::chrono::steady_clock::now();
+        std::vector<bytetrack::STrack> output_stracks = tracker.update(objects);
+        auto end = std::chrono::steady_clock::now();
+        latencies_ns.push_back(
+          std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+        for (size_t i = 0; i < output_stracks.size(); i++)
+            max_id = std::max(max_id, output_stracks[i].track_id);
+
+        if (latencies_ns.size() < window && frame + 1 < soak_frames)
+            continue;
+        std::sort(latencies_ns.begin(), latencies_ns.end());
+        double values[num_series] = { percentile(latencies_ns, 50),
+                                      percentile(latencies_ns, 99),
+                                      resident_bytes() / (1024.0 * 1024.0),
+                                      (double)tracker.get_tracked_count(),
+                                      (double)tracker.get_lost_count(),
+                                      (double)tracker.get_removed_count() };
+        for (int s = 0; s < num_series; s++)
+            series[s].push_back(values[s]);
+        printf("%12llu %10.1f %10.1f %10.1f %10.0f %10.0f %10.0f %12d\n",
+               (unsigned long long)(frame + 1),
+               values[0],
+               values[1],
+               values[2],
+               values[3],
+               values[4],
+               values[5],
+               max_id);
+        fflush(stdout);
+        latencies_ns.clear();
+    }
+
+    bool failed = false;
+    printf("\ngrowth over the run (tolerance %.0f%%):\n", tolerance * 100);
+    for (int s = 0; s < num_series; s++) {
+        double trend = relative_trend(series[s]);
+        bool drift = trend > tolerance;
+        failed = failed || drift;
+        printf("  %-8s %+8.1f%%  %s\n", names[s], trend * 100, drift ? "DRIFT" : "ok");
+    }
+    if (max_id > 0) {
+        double ids_per_frame = (double)max_id / soak_frames;
+        printf("track ids: %.3f per frame, the int counter overflows after about %.3g frames "
+               "(%.1f days at %d fps)\n",
+               ids_per_frame,
+               (double)INT_MAX / ids_per_frame,
+               INT_MAX / ids_per_frame / frame_rate / 86400.0,
+               frame_rate);
+    }
+    return failed ? 1 : 0;
+}
+
+// Replays the stream once, moving the tracking to a new tracker through save() and load()
+// every `every` frames. The tracks must come out the same as without the hand-overs.
+static int run_failover(const bytetrack::DetRecordReader& reader,
+                        int frame_rate,
+                        int track_buffer,
+                        size_t every,
+                        const std::string& output_path)
+{
+    FILE* out = nullptr;
+    if (!output_path.empty()) {
+        out = fopen(output_path.c_str(), "w");
+        if (out == nullptr) {
+            std::cerr << "Cannot open " << output_path << " for writing" << std::endl;
+            return -1;
+        }
+    }
+
+    const size_t num_frames = reader.num_frames();
+    std::unique_ptr<bytetrack::BYTETracker> tracker(
+      new bytetrack::BYTETracker(frame_rate, track_buffer));
+    std::vector<bytetrack::Object> objects;
+    std::vector<uint8_t> snapshot;
+    std::vector<int64_t> save_ns, load_ns;
+    size_t snapshot_bytes = 0, snapshot_tracks = 0;
+    for (size_t f = 0; f < num_frames; f++) {
+        reader.get_frame(f, objects);
+        std::vector<bytetrack::STrack> output_stracks = tracker->update(objects);
+
+        if (out != nullptr) {
+            for (size_t i = 0; i < output_stracks.size(); i++) {
+                const std::vector<float>& tlwh = output_stracks[i].tlwh;
+                fprintf(out,
+                        "%zu,%d,%.2f,%.2f,%.2f,%.2f,%.2f,-1,-1,-1\n",
+                        f + 1,
+                        output_stracks[i].track_id,
+                        tlwh[0],
+                        tlwh[1],
+                        tlwh[2],
+                        tlwh[3],
+                        output_stracks[i].score);
+            }
+        }
+
+        if ((f + 1) % every != 0)
+            continue;
+        auto start = std::chrono::steady_clock::now();
+        tracker->save(snapshot);
+        auto saved = std::chrono::steady_clock::now();
+        std::unique_ptr<bytetrack::BYTETracker> restored(
+          new bytetrack::BYTETracker(frame_rate, track_buffer));
+        auto created = std::chrono::steady_clock::now();
+        if (!restored->load(snapshot))
+            return -1;
+        auto loaded = std::chrono::steady_clock::now();
+        save_ns.push_back(
+          std::chrono::duration_cast<std::chrono::nanoseconds>(saved - start).count());
+        load_ns.push_back(
+          std::chrono::duration_cast<std::chrono::nanoseconds>(loaded - created).count());
+        snapshot_bytes = std::max(snapshot_bytes, snapshot.size());
+        snapshot_tracks =
+          std::max(snapshot_tracks, restored->get_tracked_count() + restored->get_lost_count());
+        tracker = std::move(restored);
+    }
+    if (out != nullptr)
+        fclose(out);
+
+    if (save_ns.empty())
+        return 0;
+    std::sort(save_ns.begin(), save_ns.end());
+    std::sort(load_ns.begin(), load_ns.end());
+    printf("snapshots:    %zu, up to %zu tracks in %.1f KB\n",
+           save_ns.size(),
+           snapshot_tracks,
+           snapshot_bytes / 1024.0);
+    printf("save us:      p50 %.1f  max %.1f\n", percentile(save_ns, 50), save_ns.back() / 1000.0);
+    printf("load us:      p50 %.1f  max %.1f\n", percentile(load_ns, 50), load_ns.back() / 1000.0);
+    return 0;
+}
+
+// Replays the stream once through a MultiClassTracker and reports the time per frame and how
+// the labels split the detections. The MOT output carries the label in the 8th column.
+static int run_multi_class(const bytetrack::DetRecordReader& reader,
+                           int frame_rate,
+                           int track_buffer,
+                           int parallel_min,
+                           const std::string& output_path)
+{
+    FILE* out = nullptr;
+    if (!output_path.empty()) {
+        out = fopen(output_path.c_str(), "w");
+        if (out == nullptr) {
+            std::cerr << "Cannot open " << output_path << " for writing" << std::endl;
+            return -1;
+        }
+    }
+
+    const size_t num_frames = reader.num_frames();
+    bytetrack::MultiClassTracker tracker(frame_rate, track_buffer, parallel_min);
+    std::vector<bytetrack::Object> objects;
+    std::vector<int64_t> latencies_ns;
+    latencies_ns.reserve(num_frames);
+    size_t num_tracks = 0;
+    for (size_t f = 0; f < num_frames; f++) {
+        reader.get_frame(f, objects);
+        auto start = std::chrono::steady_clock::now();
+        std::vector<bytetrack::STrack> output_stracks = tracker.update(objects);
+        auto end = std::chrono::steady_clock::now();
+        latencies_ns.push_back(
+          std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+        num_tracks += output_stracks.size();
+
+        if (out != nullptr) {
+            for (size_t i = 0; i < output_stracks.size(); i++) {
+                const std::vector<float>& tlwh = output_stracks[i].tlwh;
+                fprintf(out,
+                        "%zu,%d,%.2f,%.2f,%.2f,%.2f,%.2f,%d,-1,-1\n",
+                        f + 1,
+                        output_stracks[i].track_id,
+                        tlwh[0],
+                        tlwh[1],
+                        tlwh[2],
+                        tlwh[3],
+                        output_stracks[i].score,
+                        output_stracks[i].label);
+            }
+        }
+    }
+    if (out != nullptr)
+        fclose(out);
+
+    int64_t total_ns = 0;
+    for (size_t i = 0; i < latencies_ns.size(); i++)
+        total_ns += latencies_ns[i];
+    std::sort(latencies_ns.begin(), latencies_ns.end());
+    const double frames = (double)latencies_ns.size();
+    printf("frames:       %.0f\n", frames);
+    printf("classes:      %zu, %d frames associated in parallel\n",
+           tracker.get_class_count(),
+           tracker.get_parallel_frames());
+    printf("tracks/frame: %.1f\n", num_tracks / frames);
+    printf("throughput:   %.1f frames/s\n", frames * 1e9 / std::max<int64_t>(total_ns, 1));
+    printf("latency us:   mean %.1f  p50 %.1f  p90 %.1f  p99 %.1f  max %.1f\n",
+           total_ns / frames / 1000.0,
+           percentile(latencies_ns, 50),
+           percentile(latencies_ns, 90),
+           percentile(latencies_ns, 99),
+           latencies_ns.back() / 1000.0);
+    return 0;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 2) {
+        usage(argv[0]);
+        return -1;
+    }
+
+    std::string record_path = argv[1];
+    std::string output_path;
+    int passes = 1;
+    int track_buffer = 30;
+    uint64_t alloc_budget = 0;
+    size_t warmup = 100;
+    bool use_perf = false;
+    bool split = false;
+    uint64_t soak_frames = 0;
+    size_t soak_window = 10000;
+    double soak_tolerance = 0.1;
+    int detect_every = 1;
+    bool adaptive = false;
+    bytetrack::CadenceConfig cadence_config;
+    double detector_ms = 0.0;
+    double drop = 0.0;
+    bool timestamps = false;
+    bytetrack::OverloadConfig overload_config;
+    size_t snapshot_every = 0;
+    bool multi_class = false;
+    int parallel_min = 100;
+    int fps = 0;
+    for (int i = 2; i < argc; i++) {
+        if (!strcmp(argv[i], "-n") && i + 1 < argc) {
+            passes = std::max(1, atoi(argv[++i]));
+        } else if (!strcmp(argv[i], "-b") && i + 1 < argc) {
+            track_buffer = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "-o") && i + 1 < argc) {
+            output_path = argv[++i];
+        } else if (!strcmp(argv[i], "--fps") && i + 1 < argc) {
+            fps = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--alloc-budget") && i + 1 < argc) {
+            alloc_budget = strtoull(argv[++i], nullptr, 10);
+        } else if (!strcmp(argv[i], "--warmup") && i + 1 < argc) {
+            warmup = strtoull(argv[++i], nullptr, 10);
+        } else if (!strcmp(argv[i], "--perf")) {
+            use_perf = true;
+        } else if (!strcmp(argv[i], "--split")) {
+            split = true;
+        } else if (!strcmp(argv[i], "--cadence") && i + 1 < argc) {
+            adaptive = !strcmp(argv[++i], "auto");
+            detect_every = adaptive ? 1 : std::max(1, atoi(argv[i]));
+        } else if (!strcmp(argv[i], "--max-interval") && i + 1 < argc) {
+            cadence_config.max_interval = std::max(1, atoi(argv[++i]));
+        } else if (!strcmp(argv[i], "--budget-ms") && i + 1 < argc) {
+            cadence_config.budget_ms = atof(argv[++i]);
+        } else if (!strcmp(argv[i], "--detector-ms") && i + 1 < argc) {
+            detector_ms = std::max(0.0, atof(argv[++i]));
+        } else if (!strcmp(argv[i], "--drop") && i + 1 < argc) {
+            drop = std::min(std::max(0.0, atof(argv[++i])), 1.0);
+        } else if (!strcmp(argv[i], "--timestamps")) {
+            timestamps = true;
+        } else if (!strcmp(argv[i], "--update-budget-ms") && i + 1 < argc) {
+            overload_config.budget_ms = atof(argv[++i]);
+        } else if (!strcmp(argv[i], "--max-detections") && i + 1 < argc) {
+            overload_config.max_detections = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--snapshot-every") && i + 1 < argc) {
+            snapshot_every = strtoull(argv[++i], nullptr, 10);
+        } else if (!strcmp(argv[i], "--multi-class")) {
+            multi_class = true;
+        } else if (!strcmp(argv[i], "--parallel-min") && i + 1 < argc) {
+            parallel_min = std::max(0, atoi(argv[++i]));
+        } else if (!strcmp(argv[i], "--soak") && i + 1 < argc) {
+            soak_frames = strtoull(argv[++i], nullptr, 10);
+        } else if (!strcmp(argv[i], "--soak-window") && i + 1 < argc) {
+            soak_window = std::max(1ULL, strtoull(argv[++i], nullptr, 10));
+        } else if (!strcmp(argv[i], "--soak-tolerance") && i + 1 < argc) {
+            soak_tolerance = atof(argv[++i]);
+        } else {
+            usage(argv[0]);
+            return -1;
+        }
+    }
+
+    bytetrack::DetRecordReader reader;
+    if (!reader.open(record_path))
+        return -1;
+
+    const bytetrack::DetRecordHeader& header = reader.get_header();
+    const size_t num_frames = reader.num_frames();
+    std::cout << "Replaying " << num_frames << " frames, " << header.num_boxes << " detections ("
+              << header.img_w << "x" << header.img_h << " @ " << header.frame_rate << " fps)"
+              << std::endl;
+    if (num_frames == 0)
+        return 0;
+
+    // OpenCV reports 0, 1 or 25 fps for image sequences, whatever their real rate
+    const int frame_rate = fps > 0                 ? fps
+                           : header.frame_rate > 0 ? (int)header.frame_rate
+                                                   : 30;
+    if (soak_frames > 0)
+        return run_soak(reader, frame_rate, track_buffer, soak_frames, soak_window, soak_tolerance);
+    if (snapshot_every > 0)
+        return run_failover(reader, frame_rate, track_buffer, snapshot_every, output_path);
+    if (multi_class)
+        return run_multi_class(reader, frame_rate, track_buffer, parallel_min, output_path);
+    bytetrack::PerfCounters perf;
+    if (use_perf && !perf.open()) {
+        std::cerr << "Hardware counters unavailable (" << perf.get_error()
+                  << "), continuing without them" << std::endl;
+    }
+    bytetrack::PerfSample perf_total = {};
+    FILE* out = nullptr;
+    std::vector<int64_t> latencies_ns;
+    latencies_ns.reserve(num_frames * passes);
+    std::vector<bytetrack::Object> objects;
+    size_t num_tracks = 0;
+    size_t detected_frames = 0;
+    size_t dropped_frames = 0;
+    // detection frames per overload level, and those over the budget all the same
+    size_t level_frames[bytetrack::OVERLOAD_LEVEL_COUNT] = {};
+    size_t over_budget_frames = 0, dropped_detections = 0;
+    // allocations of the steady-state frames, i.e. after the warm-up of each pass
+    size_t steady_frames = 0, steady_over_budget = 0;
+    uint64_t steady_allocs = 0, steady_bytes = 0, steady_worst = 0;
+#ifdef BYTETRACK_PROFILE
+    bytetrack::TrackerProfile profile;
+#endif
+
+    for (int pass = 0; pass < passes; pass++) {
+        if (pass == passes - 1 && !output_path.empty()) {
+            out = fopen(output_path.c_str(), "w");
+            if (out == nullptr) {
+                std::cerr << "Cannot open " << output_path << " for writing" << std::endl;
+                return -1;
+            }
+        }
+
+        bytetrack::BYTETracker tracker(frame_rate, track_buffer);
+        tracker.set_overload_config(overload_config);
+        bytetrack::CadenceController cadence(cadence_config);
+        // the same frames are dropped on every pass and every run
+        std::mt19937 rng(0);
+        std::uniform_real_distribution<double> uniform(0.0, 1.0);
+#ifdef BYTETRACK_PROFILE
+        if (perf.is_open())
+            tracker.set_perf_counters(&perf);
+#endif
+        for (size_t f = 0; f < num_frames; f++) {
+            if (drop > 0.0 && uniform(rng) < drop) {
+                dropped_frames++;
+                continue;
+            }
+            const double timestamp = (double)f / frame_rate;
+            bool detect = adaptive ? cadence.should_detect() : f % detect_every == 0;
+            reader.get_frame(f, objects);
+            if (split && detect) {
+                if (timestamps)
+                    tracker.predict_next(timestamp);
+                else
+                    tracker.predict_next();
+            }
+
+            bytetrack::AllocCounters allocs_before = bytetrack::thread_alloc_counters();
+            bytetrack::PerfSample perf_before, perf_after;
+            perf.read(perf_before);
+            auto start = std::chrono::steady_clock::now();
+            std::vector<bytetrack::STrack> output_stracks;
+            if (timestamps)
+                output_stracks = detect ? tracker.update(objects, timestamp)
+                                        : tracker.predict_only(timestamp);
+            else
+                output_stracks =
+                  detect ? tracker.associate_and_update(objects) : tracker.predict_only();
+            auto end = std::chrono::steady_clock::now();
+            if (perf.read(perf_after)) {
+                for (int e = 0; e < bytetrack::PERF_EVENT_COUNT; e++)
+                    perf_total.values[e] += perf_after.values[e] - perf_before.values[e];
+            }
+            bytetrack::AllocCounters allocs =
+              bytetrack::thread_alloc_counters() - allocs_before;
+            latencies_ns.push_back(
+              std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+            num_tracks += output_stracks.size();
+            detected_frames += detect;
+            if (detect && overload_config.budget_ms > 0.f) {
+                const bytetrack::UpdateStatus& status = tracker.get_status();
+                level_frames[status.level]++;
+                over_budget_frames += status.over_budget;
+                dropped_detections += status.dropped_detections;
+            }
+            if (adaptive)
+                cadence.observe(output_stracks,
+                                detect,
+                                latencies_ns.back() / 1e6 + (detect ? detector_ms : 0.0));
+
+            if (f >= warmup) {
+                steady_frames++;
+                steady_allocs += allocs.allocations;
+                steady_bytes += allocs.bytes;
+                steady_worst = std::max(steady_worst, allocs.allocations);
+                if (allocs.allocations > alloc_budget)
+                    steady_over_budget++;
+            }
+
+            if (out != nullptr) {
+                for (size_t i = 0; i < output_stracks.size(); i++) {
+                    const std::vector<float>& tlwh = output_stracks[i].tlwh;
+                    fprintf(out,
+                            "%zu,%d,%.2f,%.2f,%.2f,%.2f,%.2f,-1,-1,-1\n",
+                            f + 1,
+                            output_stracks[i].track_id,
+                            tlwh[0],
+                            tlwh[1],
+                            tlwh[2],
+                            tlwh[3],
+                            output_stracks[i].score);
+                }
+            }
+        }
+#ifdef BYTETRACK_PROFILE
+        if (pass == passes - 1)
+            profile = tracker.get_profile();
+#endif
+    }
+    if (out != nullptr)
+        fclose(out);
+
+    int64_t total_ns = 0;
+    for (size_t i = 0; i < latencies_ns.size(); i++)
+        total_ns += latencies_ns[i];
+    std::sort(latencies_ns.begin(), latencies_ns.end());
+
+    const double frames = (double)latencies_ns.size();
+    printf("frames:       %.0f (%d pass%s)\n", frames, passes, passes > 1 ? "es" : "");
+    printf("tracks/frame: %.1f\n", num_tracks / frames);
+    printf("throughput:   %.1f frames/s\n", frames * 1e9 / std::max<int64_t>(total_ns, 1));
+    printf("latency us:   mean %.1f  p50 %.1f  p90 %.1f  p99 %.1f  p99.9 %.1f  max %.1f\n",
+           total_ns / frames / 1000.0,
+           percentile(latencies_ns, 50),
+           percentile(latencies_ns, 90),
+           percentile(latencies_ns, 99),
+           percentile(latencies_ns, 99.9),
+           latencies_ns.back() / 1000.0);
+    if (adaptive || detect_every > 1)
+        printf("detections:   %zu frames, one every %.2f\n",
+               detected_frames,
+               frames / std::max<size_t>(detected_frames, 1));
+    if (dropped_frames > 0)
+        printf("dropped:      %zu frames (%.1f%%)\n",
+               dropped_frames,
+               100.0 * dropped_frames / (frames + dropped_frames));
+    if (overload_config.budget_ms > 0.f) {
+        printf("overload:     budget %.2f ms, %zu frames over it, %zu detections left out\n",
+               overload_config.budget_ms,
+               over_budget_frames,
+               dropped_detections);
+        for (int level = 0; level < bytetrack::OVERLOAD_LEVEL_COUNT; level++)
+            printf("  %-13s %zu frames\n",
+                   bytetrack::overload_level_name(level),
+                   level_frames[level]);
+    }
+    if (detector_ms > 0.0)
+        printf("with a %.1f ms detector: %.1f frames/s\n",
+               detector_ms,
+               frames * 1000.0 / (detected_frames * detector_ms + total_ns / 1e6));
+    if (perf.is_open()) {
+        printf("per frame: ");
+        for (int e = 0; e < bytetrack::PERF_EVENT_COUNT; e++) {
+            if (perf.available(e))
+                printf("  %s %.0f", bytetrack::perf_event_name(e), perf_total.values[e] / frames);
+        }
+        if (perf.available(bytetrack::PERF_CYCLES) && perf.available(bytetrack::PERF_INSTRUCTIONS))
+            printf(" IPC %.2f",
+                   (double)perf_total.values[bytetrack::PERF_INSTRUCTIONS] /
+                     std::max<uint64_t>(perf_total.values[bytetrack::PERF_CYCLES], 1));
+        printf("\n");
+    }
+#ifdef BYTETRACK_PROFILE
+    std::cout << std::endl << "Per-stage profile of the last pass" << std::endl;
+    profile.print(std::cout);
+#endif
+
+    if (bytetrack::alloc_accounting_enabled() && steady_frames > 0) {
+        printf("\nsteady state: %zu frames, %.1f allocations and %.1f KB per frame, worst %llu\n",
+               steady_frames,
+               (double)steady_allocs / steady_frames,
+               steady_bytes / 1024.0 / steady_frames,
+               (unsigned long long)steady_worst);
+        if (steady_over_budget > 0) {
+            printf("ALLOCATION REGRESSION: %zu of %zu steady-state frames exceed the budget of "
+                   "%llu allocations per frame\n",
+                   steady_over_budget,
+                   steady_frames,
+                   (unsigned long long)alloc_budget);
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -16,9 +16,39 @@ public:
 	~BYTETracker();
 
 	vector<STrack> update(const vector<Object>& objects);
+	// update() for a frame taken at `timestamp` seconds, for streams that drop frames or
+	// arrive at a variable rate: the tracks are predicted over the time elapsed since the
+	// previous frame, and lost tracks are removed after track_buffer / 30 seconds instead
+	// of a number of frames. Timestamps must not decrease; do not mix with the calls
+	// without one on the same tracker.
+	vector<STrack> update(const vector<Object>& objects, double timestamp);
+
+	// update() in two steps. predict_next() moves the tracks to the next frame with the
+	// Kalman filter and builds the candidate lists for association; it only depends on the
+	// previous update, so the pipelined demo runs it while the detector works on the next
+	// frame. associate_and_update() then matches the detections against the predicted
+	// tracks, and predicts first itself if predict_next() was not called. Call both from
+	// the same thread.
+	void predict_next();
+	void predict_next(double timestamp);
+	vector<STrack> associate_and_update(const vector<Object>& objects);
+	// Steps to the next frame without detections, for the frames the demo skips the
+	// detector on: the tracks move with the Kalman filter and nothing is associated, lost
+	// or removed. Returns the activated tracks at their predicted boxes. The lost tracks
+	// keep aging, so max_time_lost still counts frames (or time, with timestamps).
+	vector<STrack> predict_only();
+	vector<STrack> predict_only(double timestamp);
+	// Where the tracks are expected on the coming frame, for detectors that only look there:
+	// runs predict_next(), after predict_next(timestamp) if any, and returns the predicted boxes of the activated and lost tracks
+	// and the last boxes of the unconfirmed ones, in frame coordinates.
+	void predicted_boxes(vector<Rect_<float> >& boxes);
 	Scalar get_color(int idx);
 
 private:
+	// sets the time of the coming frame: one frame period on, or the given timestamp
+	void advance_clock();
+	void advance_clock(double timestamp);
+
 	vector<STrack*> joint_stracks(vector<STrack*> &tlista, vector<STrack> &tlistb);
 	vector<STrack> joint_stracks(vector<STrack> &tlista, vector<STrack> &tlistb);
 
@@ -41,9 +71,23 @@ private:
 	float match_thresh;
 	int frame_id;
 	int max_time_lost;
+	float frame_rate;
+
+	// the clock: timestamp of the last frame, and of the coming one with the time step to
+	// it in frames of the nominal rate, once advance_clock() ran for it
+	bool timed;
+	bool clock_advanced;
+	double timestamp;
+	double next_timestamp;
+	float next_dt;
 
 	vector<STrack> tracked_stracks;
 	vector<STrack> lost_stracks;
 	vector<STrack> removed_stracks;
 	kalman::KalmanFilter kalman_filter;
+
+	// left by predict_next(), pointing into tracked_stracks and lost_stracks
+	bool predicted;
+	vector<STrack*> unconfirmed_pool;
+	vector<STrack*> strack_pool;
 };
\ No newline at end of file
@@ -15,7 +15,7 @@ public:
 	~STrack();
 
 	vector<float> static tlbr_to_tlwh(vector<float> &tlbr);
-	void static multi_predict(vector<STrack*> &stracks, kalman::KalmanFilter &kalman_filter);
+	void static multi_predict(vector<STrack*> &stracks, kalman::KalmanFilter &kalman_filter, float dt = 1.f);
 	void static_tlwh();
 	void static_tlbr();
 	vector<float> tlwh_to_xyah(vector<float> tlwh_tmp);
@@ -40,6 +40,7 @@ public:
 	int frame_id;
 	int tracklet_len;
 	int start_frame;
+	double timestamp; // of the frame of the last detection, seconds
 
 	KAL_MEAN mean;
 	KAL_COVA covariance;
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "STrack.h"
+
+#include <vector>
+
+struct CadenceConfig
+{
+    int max_interval = 4; // at most this many frames per detection
+    // drift of a track, relative to its height, that the Kalman prediction may accumulate
+    // between two detections before the association starts to miss it
+    float max_shift = 0.25f;
+    // processing time per frame to stay within, 0 for none (e.g. 1000 / fps for real time)
+    float budget_ms = 0.f;
+};
+
+// Picks how often a pipeline runs the detector, the frames in between being carried by
+// BYTETracker::predict_only(). The interval is the number of frames the 90th percentile
+// track needs to drift max_shift of its height at its Kalman velocity, shrunk by the
+// fraction of tracks that overlap another one, since a small drift already swaps the
+// identities of touching boxes. With nothing tracked every frame is detected. A budget
+// then raises the interval until the mean time per frame fits in it, so the budget wins
+// over accuracy, up to max_interval. Same controller as
+// deploy/TensorRT/cpp/include/cadenceController.h.
+class CadenceController
+{
+public:
+    explicit CadenceController(const CadenceConfig& config);
+
+    // true when the coming frame should run the detector
+    bool should_detect();
+    // after the tracker step of that frame: the tracks it returned and the processing
+    // time of the frame, detection included
+    void observe(const std::vector<STrack>& tracks, bool detected, double frame_ms);
+
+    int get_interval() const { return interval; }
+    int get_frames() const { return frames; }
+    int get_detected_frames() const { return detected_frames; }
+    // of the last detection frame
+    float get_motion() const { return motion; }
+    float get_crowding() const { return crowding; }
+
+private:
+    void measure(const std::vector<STrack>& tracks);
+    int budget_interval() const;
+
+    CadenceConfig config;
+    int interval;
+    int since_detection; // frames since the last detection
+    int frames;
+    int detected_frames;
+
+    float motion;     // 90th percentile of |velocity| / height, per frame
+    float crowding;   // fraction of tracks overlapping another
+    double detect_ms; // running means of both kinds of frames
+    double predict_ms;
+
+    // reused by measure()
+    std::vector<float> speeds;
+    std::vector<int> order;
+    std::vector<char> overlapping;
+};
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "BYTETracker.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+// Binary detection record (.btdr) shared with deploy/TensorRT/cpp, little endian:
+//
+//   DetRecordHeader
+//   DetRecordBox[num_boxes]     detections of all frames, packed frame after frame
+//   uint64_t[num_frames + 1]    index of the first box of each frame, plus the total
+//
+// Replay it with bytetrack_replay from deploy/TensorRT/cpp/tools.
+static const char DET_RECORD_MAGIC[4] = {'B', 'T', 'D', 'R'};
+static const uint32_t DET_RECORD_VERSION = 1;
+
+struct DetRecordHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t frame_rate;
+    uint32_t img_w;
+    uint32_t img_h;
+    uint32_t reserved;
+    uint64_t num_frames;
+    uint64_t num_boxes;
+    uint64_t offsets_pos; // byte position of the frame offset table
+};
+
+struct DetRecordBox
+{
+    float x;
+    float y;
+    float w;
+    float h;
+    float prob;
+    int32_t label;
+};
+
+class DetRecordWriter
+{
+public:
+    DetRecordWriter();
+    ~DetRecordWriter();
+
+    bool open(const std::string& path, int frame_rate, int img_w, int img_h);
+    bool write_frame(const std::vector<Object>& objects);
+    bool close();
+    bool is_open() const { return file != NULL; }
+
+private:
+    FILE* file;
+    DetRecordHeader header;
+    std::vector<uint64_t> offsets;
+    std::vector<DetRecordBox> boxes;
+};
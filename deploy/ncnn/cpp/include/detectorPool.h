@@ -0,0 +1,167 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "net.h"
+
+// Serves the frames of several streams with one loaded ncnn::Net. `detectors` worker
+// threads each run one inference at a time with `threads_per_detector` threads, so the
+// weights are loaded once however many streams there are.
+//
+// Every stream has its own queue of at most `max_pending` frames. A free worker takes the
+// oldest frame of the next stream in turn that has one, so a stream that decodes faster
+// than the others cannot starve them, and a stream gets several workers when the others
+// are idle. Frames of one stream may finish out of order: the work function hands them to
+// something like a ReorderBuffer.
+//
+// Job needs an int `stream` member, in [0, streams).
+template<typename Job>
+class DetectorPool
+{
+public:
+    // Runs one job on worker `detector`, with a fresh extractor of the shared net: an
+    // extractor keeps the blobs of the inference it ran.
+    typedef std::function<void(ncnn::Extractor& ex, int detector, Job& job)> Work;
+
+    DetectorPool(const ncnn::Net& net, int streams, int detectors, int threads_per_detector, size_t max_pending,
+                 Work work)
+        : net(net), threads_per_detector(threads_per_detector), max_pending(max_pending), work(work),
+          pending(streams), running(streams, 0), stream_frames(streams, 0), next_stream(0), closed(false),
+          busy_us(detectors, 0), detector_frames(detectors, 0)
+    {
+        for (int i = 0; i < detectors; i++)
+            workers.push_back(std::thread(&DetectorPool::run, this, i));
+    }
+
+    ~DetectorPool()
+    {
+        close();
+    }
+
+    // Queues a frame, waiting while its stream already has max_pending frames queued.
+    void submit(Job& job)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        space.wait(lock, [&]() { return pending[job.stream].size() < max_pending; });
+        pending[job.stream].push_back(job);
+        ready.notify_one();
+    }
+
+    // Waits until every frame submitted for `stream` has been through the work function.
+    void wait_idle(int stream)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        idle.wait(lock, [&]() { return pending[stream].empty() && running[stream] == 0; });
+    }
+
+    // Runs what is queued, then stops and joins the workers.
+    void close()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            closed = true;
+            ready.notify_all();
+        }
+        for (size_t i = 0; i < workers.size(); i++)
+            workers[i].join();
+        workers.clear();
+    }
+
+    int detectors() const
+    {
+        return (int)busy_us.size();
+    }
+
+    // per worker, valid after close()
+    int64_t detector_busy_us(int detector) const
+    {
+        return busy_us[detector];
+    }
+
+    int detector_frame_count(int detector) const
+    {
+        return detector_frames[detector];
+    }
+
+    int stream_frame_count(int stream) const
+    {
+        return stream_frames[stream];
+    }
+
+private:
+    // the next stream with a queued frame, in turn; -1 if none
+    int pick_stream()
+    {
+        const int streams = (int)pending.size();
+        for (int i = 0; i < streams; i++)
+        {
+            int s = (next_stream + i) % streams;
+            if (!pending[s].empty())
+            {
+                next_stream = (s + 1) % streams;
+                return s;
+            }
+        }
+        return -1;
+    }
+
+    void run(int detector)
+    {
+        for (;;)
+        {
+            Job job;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                int s;
+                ready.wait(lock, [&]() { return (s = pick_stream()) >= 0 || closed; });
+                if (s < 0)
+                    return;
+                job = pending[s].front();
+                pending[s].pop_front();
+                running[s]++;
+                space.notify_all();
+            }
+
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            ncnn::Extractor ex = net.create_extractor();
+            ex.set_num_threads(threads_per_detector);
+            work(ex, detector, job);
+            busy_us[detector] += std::chrono::duration_cast<std::chrono::microseconds>(
+                                     std::chrono::steady_clock::now() - start).count();
+            detector_frames[detector]++;
+
+            std::lock_guard<std::mutex> lock(mutex);
+            running[job.stream]--;
+            stream_frames[job.stream]++;
+            if (pending[job.stream].empty() && running[job.stream] == 0)
+                idle.notify_all();
+        }
+    }
+
+    const ncnn::Net& net;
+    const int threads_per_detector;
+    const size_t max_pending;
+    Work work;
+
+    std::mutex mutex;
+    std::condition_variable ready; // a frame was queued, or the pool closed
+    std::condition_variable space; // a stream queue has room
+    std::condition_variable idle;  // a stream has nothing queued or running
+    std::vector<std::deque<Job> > pending;
+    std::vector<int> running;
+    std::vector<int> stream_frames;
+    int next_stream;
+    bool closed;
+
+    std::vector<int64_t> busy_us; // each written by its worker only
+    std::vector<int> detector_frames;
+    std::vector<std::thread> workers;
+};
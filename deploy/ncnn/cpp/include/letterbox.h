@@ -0,0 +1,52 @@
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+
+#include "mat.h"
+#include <opencv2/core/core.hpp>
+
+// Network input in one pass over the frame: letterbox resize (bilinear, top-left aligned,
+// padded with a constant gray), BGR to RGB, (x - mean) * norm and HWC to CHW, written
+// straight into an ncnn::Mat. It replaces static_resize + from_pixels_resize +
+// substract_mean_normalize, which copied the frame three times.
+//
+// Same kernel as deploy/TensorRT/cpp/include/letterbox.h: the resize uses the fixed-point
+// arithmetic of cv::resize(INTER_LINEAR) for 8-bit images, so the input matches the old
+// path up to float rounding.
+class LetterboxPreprocessor
+{
+public:
+    // mean_vals and norm_vals per RGB channel, for pixel values in [0, 255], as taken by
+    // ncnn::Mat::substract_mean_normalize
+    LetterboxPreprocessor(int dst_w, int dst_h, const float mean_vals[3], const float norm_vals[3],
+                          int pad_value = 114);
+
+    // Fills `in` (dst_w x dst_h x 3, reused when it already has that shape) from an 8-bit BGR
+    // image, with the rows split over `threads` OpenMP threads. Returns the resize factor
+    // from the source image to the network input.
+    float run(const cv::Mat& bgr, ncnn::Mat& in, int threads = 1);
+
+private:
+    void prepare(int width, int height, int threads);
+    void resize_row(const cv::Mat& bgr, int src_row, int32_t* out) const;
+    void process_rows(const cv::Mat& bgr, ncnn::Mat& in, int begin, int end, int32_t* rows) const;
+
+    int dst_w;
+    int dst_h;
+    float norm[3];
+    float bias[3];       // -mean * norm
+    float pad_values[3]; // normalized padding, per RGB channel
+
+    // resize tables for the current source size
+    int src_w;
+    int src_h;
+    int unpad_w;
+    int unpad_h;
+    float scale;
+    std::vector<int> x_ofs;      // byte offsets of the left and right neighbours
+    std::vector<int16_t> x_coef; // left and right weights, 11 bits
+    std::vector<int> y_ofs;      // upper neighbour row, per destination row
+    std::vector<int16_t> y_coef; // upper and lower weights, 11 bits
+    std::vector<int32_t> scratch; // two horizontally resized rows (RGB planes) per thread
+};
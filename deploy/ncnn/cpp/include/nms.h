@@ -0,0 +1,55 @@
+#pragma once
+
+#include <vector>
+#include "BYTETracker.h"
+
+// Greedy non-maximum suppression: proposals are visited by descending score and a
+// proposal is kept unless its IoU with an already kept one exceeds the threshold.
+//
+// The boxes are copied once into flat coordinate arrays, and the IoU of a candidate is
+// computed against blocks of kept boxes in a loop the compiler vectorizes. With many
+// proposals, the kept boxes are also binned into a coarse grid, so that a candidate is
+// only compared with the kept boxes of the cells it covers. All buffers are reused across
+// calls, so one engine is needed per thread. Same engine as deploy/TensorRT/cpp/include/nms.h.
+class NmsEngine
+{
+public:
+    // top_k > 0 keeps only the top_k best proposals before suppression (a partial sort
+    // instead of a full one). per_class only lets boxes of the same label suppress each other.
+    explicit NmsEngine(float iou_threshold, int top_k = 0, bool per_class = false);
+
+    // Indices into proposals of the kept boxes, by descending score (ties by index).
+    void run(const std::vector<Object>& proposals, std::vector<int>& picked);
+
+private:
+    struct BoxSet
+    {
+        std::vector<float> x0, y0, x1, y1, area;
+
+        void clear();
+        void push(float bx0, float by0, float bx1, float by1, float barea);
+        bool overlaps(float bx0, float by0, float bx1, float by1, float barea, float thresh) const;
+    };
+
+    void suppress(const int* begin, const int* end, std::vector<int>& out);
+    void cell_range(int i, int& cx0, int& cy0, int& cx1, int& cy1) const;
+
+    float iou_threshold;
+    int top_k;
+    bool per_class;
+
+    std::vector<int> order; // proposal indices by descending score
+    BoxSet boxes;           // in `order`
+    std::vector<int> labels;
+    std::vector<int> kept_positions;
+    std::vector<int> class_order;
+
+    // kept boxes, in a single set or per grid cell
+    BoxSet kept;
+    std::vector<BoxSet> cells;
+    int grid_w;
+    int grid_h;
+    float grid_x0;
+    float grid_y0;
+    float inv_cell;
+};
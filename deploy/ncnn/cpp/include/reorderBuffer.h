@@ -0,0 +1,98 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+
+// Puts items produced out of order by several threads back in sequence order for a single
+// consumer. Producers push(seq, item) with consecutive sequence numbers starting at
+// `first`; pop() hands them out strictly in that order, waiting for a gap to be filled.
+//
+// At most `window` sequence numbers are held at once: a producer that runs ahead of the
+// consumer by more than that waits, which bounds memory and the latency added to the
+// frames behind a slow one. The item the consumer waits for is always inside the window,
+// so its producer never blocks. Each producer calls close() once after its last item;
+// pop() returns false when all of them have closed and the buffer is drained.
+template<typename T>
+class ReorderBuffer
+{
+public:
+    ReorderBuffer(size_t window, int producers, uint64_t first = 0)
+        : slots(window), filled(window, false), next(first), open_producers(producers),
+          held(0), pops(0), held_sum(0), max_held(0)
+    {
+    }
+
+    void push(uint64_t seq, T& item)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        space.wait(lock, [&]() { return seq < next + slots.size(); });
+        size_t i = seq % slots.size();
+        slots[i] = item;
+        filled[i] = true;
+        held++;
+        if (held > max_held)
+            max_held = held;
+        if (seq == next)
+            ready.notify_one();
+    }
+
+    // false once every producer has closed and no item is left
+    bool pop(T& item)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        size_t i = next % slots.size();
+        ready.wait(lock, [&]() { return filled[i] || (open_producers == 0 && held == 0); });
+        if (!filled[i])
+            return false;
+        item = slots[i];
+        slots[i] = T(); // drop the references held by the slot
+        filled[i] = false;
+        held_sum += held;
+        pops++;
+        held--;
+        next++;
+        space.notify_all();
+        return true;
+    }
+
+    void close()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        open_producers--;
+        ready.notify_one();
+    }
+
+    size_t capacity() const
+    {
+        return slots.size();
+    }
+
+    // mean number of items held when pop() returned one, including that one
+    double mean_fill()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return pops ? (double)held_sum / pops : 0.0;
+    }
+
+    size_t max_fill()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return max_held;
+    }
+
+private:
+    std::mutex mutex;
+    std::condition_variable ready; // the next item arrived, or the last producer closed
+    std::condition_variable space; // the window moved
+    std::vector<T> slots;
+    std::vector<bool> filled;
+    uint64_t next;
+    int open_producers;
+    size_t held;
+    uint64_t pops;
+    uint64_t held_sum;
+    size_t max_held;
+};
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <vector>
+
+#include "mat.h"
+#include "BYTETracker.h"
+
+// Network input made of the parts of a frame where objects are expected, for the frames
+// between full-frame detections.
+//
+// Each predicted track box is dilated by a margin, and one edge strip of the frame is
+// added in turn so that objects entering the scene are still found. Overlapping regions
+// are merged, so that an object is seen by one crop only. The crops are resized at the
+// scale of the full-frame letterbox, so objects keep the size the detector sees on full
+// frames, and packed in rows, separated by gray gaps, into a mosaic no wider than the
+// full-frame input and rounded up to the network stride. The detections of the mosaic are
+// mapped back to frame coordinates.
+class RoiMosaic
+{
+public:
+    // max_w: width of the full-frame network input; align: network stride
+    RoiMosaic(int max_w, int align, int pad_value = 114);
+
+    // Lays out the regions around `boxes` (frame coordinates) for a frame letterboxed at
+    // `scale`, with edge strip `edge` (0 left, 1 top, 2 right, 3 bottom, -1 none). Returns
+    // false when the mosaic would cover more than max_fraction of full_area, in which case
+    // the frame is better detected whole.
+    bool plan(const std::vector<cv::Rect_<float> >& boxes, int img_w, int img_h, float scale, int edge,
+              int full_area, float max_fraction);
+
+    // Fills the network input from the planned regions of `bgr`.
+    void build(const cv::Mat& bgr, ncnn::Mat& in, const float mean_vals[3], const float norm_vals[3]);
+
+    // Detections in mosaic coordinates to frame coordinates. A detection belongs to the crop
+    // that holds its center and is clipped to it; the ones centered in a gap are dropped.
+    void map_back(std::vector<Object>& objects) const;
+
+    int width() const { return mosaic_w; }
+    int height() const { return mosaic_h; }
+    int tiles() const { return (int)crops.size(); }
+
+private:
+    int max_w;
+    int align;
+    int pad_value;
+
+    std::vector<cv::Rect> crops; // in the frame
+    std::vector<cv::Rect> slots; // in the mosaic, same order
+    int mosaic_w;
+    int mosaic_h;
+
+    std::vector<cv::Rect> regions; // reused by plan()
+    std::vector<int> order;
+    cv::Mat canvas;
+};
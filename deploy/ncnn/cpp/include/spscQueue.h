@@ -0,0 +1,118 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+// Bounded single-producer single-consumer queue. One thread pushes, one thread pops; the
+// two only share the head and tail indices, which live on separate cache lines, so neither
+// side ever takes a lock. Items come out in the order they went in.
+//
+// push() and pop() wait when the queue is full or empty, spinning briefly and then sleeping
+// in short steps, since the stages around a queue may take tens of milliseconds per frame.
+// The producer calls close() after its last item; pop() then drains the queue and returns
+// false.
+template<typename T>
+class SpscQueue
+{
+public:
+    explicit SpscQueue(size_t capacity)
+        : head(0), tail(0), closed(false), pushes(0), fill_sum(0)
+    {
+        size_t n = 1;
+        while (n < capacity)
+            n <<= 1;
+        slots.resize(n);
+        mask = n - 1;
+    }
+
+    bool try_push(T& item)
+    {
+        size_t t = tail.load(std::memory_order_relaxed);
+        size_t used = t - head.load(std::memory_order_acquire);
+        if (used > mask)
+            return false;
+        slots[t & mask] = item;
+        tail.store(t + 1, std::memory_order_release);
+        // only the producer writes these
+        pushes.store(pushes.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        fill_sum.store(fill_sum.load(std::memory_order_relaxed) + used + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    bool try_pop(T& item)
+    {
+        size_t h = head.load(std::memory_order_relaxed);
+        if (h == tail.load(std::memory_order_acquire))
+            return false;
+        item = slots[h & mask];
+        slots[h & mask] = T(); // drop the references held by the slot
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    void push(T& item)
+    {
+        for (int spins = 0; !try_push(item); spins++)
+            backoff(spins);
+    }
+
+    // false once the queue is closed and empty
+    bool pop(T& item)
+    {
+        for (int spins = 0; !try_pop(item); spins++)
+        {
+            if (closed.load(std::memory_order_acquire))
+                return try_pop(item);
+            backoff(spins);
+        }
+        return true;
+    }
+
+    void close()
+    {
+        closed.store(true, std::memory_order_release);
+    }
+
+    size_t capacity() const
+    {
+        return mask + 1;
+    }
+
+    size_t size() const
+    {
+        return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire);
+    }
+
+    // mean number of queued items seen by push(), including the pushed one
+    double mean_fill() const
+    {
+        uint64_t n = pushes.load(std::memory_order_relaxed);
+        return n ? (double)fill_sum.load(std::memory_order_relaxed) / n : 0.0;
+    }
+
+private:
+    static void backoff(int spins)
+    {
+        if (spins < 64)
+            std::this_thread::yield();
+        else
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+    }
+
+    // padding rather than alignas keeps the indices on separate cache lines without needing
+    // an over-aligned operator new, which C++11 does not have
+    std::vector<T> slots;
+    size_t mask;
+    char pad0[64];
+    std::atomic<size_t> head; // next slot to pop, written by the consumer
+    char pad1[64 - sizeof(std::atomic<size_t>)];
+    std::atomic<size_t> tail; // next slot to push, written by the producer
+    char pad2[64 - sizeof(std::atomic<size_t>)];
+    std::atomic<bool> closed;
+    std::atomic<uint64_t> pushes;
+    std::atomic<uint64_t> fill_sum;
+};
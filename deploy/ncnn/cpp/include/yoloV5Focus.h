@@ -0,0 +1,22 @@
+#pragma once
+
+#include "layer.h"
+
+// YOLOX use the same focus in yolov5
+//
+// Space to depth: output channel p is the (p / channels)-th phase of input channel
+// p % channels, phase 0 taking the even rows and even columns, 1 the odd rows and even
+// columns, 2 the even rows and odd columns and 3 the odd rows and odd columns. The rows are
+// split into their even and odd columns with SIMD loads (NEON, SSE2, AVX2), and the output
+// is written in the packed layout the next convolution runs on (pack4, or pack8 with AVX),
+// so ncnn does not convert it. It only moves values, so fp16 and bf16 storage go through
+// the same code on 16-bit elements.
+class YoloV5Focus : public ncnn::Layer
+{
+public:
+    YoloV5Focus();
+
+    virtual int forward(const ncnn::Mat& bottom_blob, ncnn::Mat& top_blob, const ncnn::Option& opt) const;
+};
+
+ncnn::Layer* YoloV5Focus_layer_creator(void* userdata);
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <vector>
+#include "BYTETracker.h"
+
+// Turns the raw YOLOX head output into box proposals in input pixels. The output has one
+// row per anchor (x, y, log w, log h, objectness, then one score per class), anchors
+// ordered by stride, then grid row, then grid column.
+//
+// Same decoder as deploy/TensorRT/cpp/include/yoloxDecoder.h: the anchor grid of an input
+// size is built once, each anchor is scored with objectness * best class score first, and
+// only the ones above the threshold go through exp and the box math. decode() returns a
+// buffer owned by the decoder, which the caller may sort in place and which the next call
+// overwrites, so every detector thread needs its own decoder.
+class YoloxDecoder
+{
+public:
+    YoloxDecoder();
+
+    // Proposals in anchor order, then class order, for every class score with
+    // objectness * score > prob_threshold.
+    std::vector<Object>& decode(const float* feat, int num_classes, int input_w, int input_h,
+                                float prob_threshold);
+
+    int get_num_anchors() const { return (int)grid_x.size(); }
+
+    // rows of the head output for an input_w x input_h input
+    static int count_anchors(int input_w, int input_h);
+
+private:
+    void prepare(int input_w, int input_h);
+
+    int input_w;
+    int input_h;
+
+    // per anchor, for the current input size
+    std::vector<float> grid_x;
+    std::vector<float> grid_y;
+    std::vector<float> strides;
+    std::vector<float> scores;
+
+    std::vector<int> candidates; // anchors above the threshold
+    std::vector<Object> proposals;
+};
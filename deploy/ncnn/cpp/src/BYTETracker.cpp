@@ -1,4 +1,5 @@
 #include "BYTETracker.h"
+#include <algorithm>
 #include <fstream>
 
 BYTETracker::BYTETracker(int frame_rate, int track_buffer)
@@ -8,7 +9,15 @@ BYTETracker::BYTETracker(int frame_rate, int track_buffer)
 	match_thresh = 0.8;
 
 	frame_id = 0;
+	predicted = false;
 	max_time_lost = int(frame_rate / 30.0 * track_buffer);
+	this->frame_rate = frame_rate;
+
+	timed = false;
+	clock_advanced = false;
+	timestamp = 0;
+	next_timestamp = 0;
+	next_dt = 1.f;
 	cout << "Init ByteTrack!" << endl;
 }
 
@@ -17,10 +26,121 @@ BYTETracker::~BYTETracker()
 }
 
 vector<STrack> BYTETracker::update(const vector<Object>& objects)
+{
+	return associate_and_update(objects);
+}
+
+vector<STrack> BYTETracker::update(const vector<Object>& objects, double timestamp)
+{
+	predict_next(timestamp);
+	return associate_and_update(objects);
+}
+
+void BYTETracker::advance_clock()
+{
+	this->next_timestamp = this->timestamp + 1.0 / this->frame_rate;
+	this->next_dt = 1.f;
+	this->clock_advanced = true;
+}
+
+void BYTETracker::advance_clock(double timestamp)
+{
+	this->timed = true;
+	this->next_timestamp = timestamp;
+	if (this->frame_id == 0)
+		this->next_dt = 1.f;
+	else
+		this->next_dt = std::max(0.f, float((timestamp - this->timestamp) * this->frame_rate));
+	this->clock_advanced = true;
+}
+
+void BYTETracker::predict_next(double timestamp)
+{
+	if (this->predicted)
+		return;
+	advance_clock(timestamp);
+	predict_next();
+}
+
+void BYTETracker::predict_next()
+{
+	if (this->predicted)
+		return;
+	if (!this->clock_advanced)
+		advance_clock();
+
+	// Add newly detected tracklets to tracked_stracks
+	vector<STrack*> tracked_stracks;
+	this->unconfirmed_pool.clear();
+	for (int i = 0; i < this->tracked_stracks.size(); i++)
+	{
+		if (!this->tracked_stracks[i].is_activated)
+			this->unconfirmed_pool.push_back(&this->tracked_stracks[i]);
+		else
+			tracked_stracks.push_back(&this->tracked_stracks[i]);
+	}
+
+	this->strack_pool = joint_stracks(tracked_stracks, this->lost_stracks);
+	STrack::multi_predict(this->strack_pool, this->kalman_filter, this->next_dt);
+	this->predicted = true;
+}
+
+vector<STrack> BYTETracker::predict_only(double timestamp)
+{
+	predict_next(timestamp);
+	return predict_only();
+}
+
+vector<STrack> BYTETracker::predict_only()
+{
+	this->frame_id++;
+	predict_next();
+	this->predicted = false;
+	this->timestamp = this->next_timestamp;
+	this->clock_advanced = false;
+	this->unconfirmed_pool.clear();
+	this->strack_pool.clear();
+
+	// the associations compare against these boxes, so the next detection frame matches
+	// the prediction for the frame before it, as after an update
+	vector<STrack> output_stracks;
+	for (int i = 0; i < this->tracked_stracks.size(); i++)
+	{
+		STrack& track = this->tracked_stracks[i];
+		if (!track.is_activated)
+			continue;
+		track.static_tlwh();
+		track.static_tlbr();
+		output_stracks.push_back(track);
+	}
+	return output_stracks;
+}
+
+void BYTETracker::predicted_boxes(vector<Rect_<float> >& boxes)
+{
+	predict_next();
+	boxes.clear();
+	for (int i = 0; i < this->strack_pool.size(); i++)
+	{
+		// mean is x, y, a, h of the box center
+		const KAL_MEAN& mean = this->strack_pool[i]->mean;
+		float w = mean(2) * mean(3);
+		boxes.push_back(Rect_<float>(mean(0) - w / 2, mean(1) - mean(3) / 2, w, mean(3)));
+	}
+	for (int i = 0; i < this->unconfirmed_pool.size(); i++)
+	{
+		const vector<float>& tlwh = this->unconfirmed_pool[i]->tlwh;
+		boxes.push_back(Rect_<float>(tlwh[0], tlwh[1], tlwh[2], tlwh[3]));
+	}
+}
+
+vector<STrack> BYTETracker::associate_and_update(const vector<Object>& objects)
 {
 
 	////////////////// Step 1: Get detections //////////////////
 	this->frame_id++;
+	if (!this->clock_advanced)
+		advance_clock();
 	vector<STrack> activated_stracks;
 	vector<STrack> refind_stracks;
 	vector<STrack> removed_stracks;
@@ -33,9 +153,6 @@ vector<STrack> BYTETracker::update(const vector<Object>& objects)
 	vector<STrack> resa, resb;
 	vector<STrack> output_stracks;
 
-	vector<STrack*> unconfirmed;
-	vector<STrack*> tracked_stracks;
-	vector<STrack*> strack_pool;
 	vector<STrack*> r_tracked_stracks;
 
 	if (objects.size() > 0)
@@ -52,6 +169,7 @@ vector<STrack> BYTETracker::update(const vector<Object>& objects)
 			float score = objects[i].prob;
 
 			STrack strack(STrack::tlbr_to_tlwh(tlbr_), score);
+			strack.timestamp = this->next_timestamp;
 			if (score >= track_thresh)
 			{
 				detections.push_back(strack);
@@ -64,18 +182,11 @@ vector<STrack> BYTETracker::update(const vector<Object>& objects)
 		}
 	}
 
-	// Add newly detected tracklets to tracked_stracks
-	for (int i = 0; i < this->tracked_stracks.size(); i++)
-	{
-		if (!this->tracked_stracks[i].is_activated)
-			unconfirmed.push_back(&this->tracked_stracks[i]);
-		else
-			tracked_stracks.push_back(&this->tracked_stracks[i]);
-	}
-
 	////////////////// Step 2: First association, with IoU //////////////////
-	strack_pool = joint_stracks(tracked_stracks, this->lost_stracks);
-	STrack::multi_predict(strack_pool, this->kalman_filter);
+	predict_next();
+	this->predicted = false;
+	vector<STrack*>& unconfirmed = this->unconfirmed_pool;
+	vector<STrack*>& strack_pool = this->strack_pool;
 
 	vector<vector<float> > dists;
 	int dist_size = 0, dist_size_size = 0;
@@ -187,9 +298,19 @@ vector<STrack> BYTETracker::update(const vector<Object>& objects)
 	}
 
 	////////////////// Step 5: Update state //////////////////
+	// the pools point into the lists rebuilt below
+	unconfirmed.clear();
+	strack_pool.clear();
+	this->timestamp = this->next_timestamp;
+	this->clock_advanced = false;
+
 	for (int i = 0; i < this->lost_stracks.size(); i++)
 	{
-		if (this->frame_id - this->lost_stracks[i].end_frame() > this->max_time_lost)
+		// with timestamps, half a frame of slack keeps their rounding from deciding
+		bool expired = this->timed
+			? this->timestamp - this->lost_stracks[i].timestamp > (this->max_time_lost + 0.5) / this->frame_rate
+			: this->frame_id - this->lost_stracks[i].end_frame() > this->max_time_lost;
+		if (expired)
 		{
 			this->lost_stracks[i].mark_removed();
 			removed_stracks.push_back(this->lost_stracks[i]);
@@ -18,6 +18,7 @@ STrack::STrack(vector<float> tlwh_, float score)
 	tracklet_len = 0;
 	this->score = score;
 	start_frame = 0;
+	timestamp = 0;
 }
 
 STrack::~STrack()
@@ -77,6 +78,7 @@ void STrack::re_activate(STrack &new_track, int frame_id, bool new_id)
 	this->state = TrackState::Tracked;
 	this->is_activated = true;
 	this->frame_id = frame_id;
+	this->timestamp = new_track.timestamp;
 	this->score = new_track.score;
 	if (new_id)
 		this->track_id = next_id();
@@ -85,6 +87,7 @@ void STrack::re_activate(STrack &new_track, int frame_id, bool new_id)
 void STrack::update(STrack &new_track, int frame_id)
 {
 	this->frame_id = frame_id;
+	this->timestamp = new_track.timestamp;
 	this->tracklet_len++;
 
 	vector<float> xyah = tlwh_to_xyah(new_track.tlwh);
@@ -179,7 +182,7 @@ int STrack::end_frame()
 	return this->frame_id;
 }
 
-void STrack::multi_predict(vector<STrack*> &stracks, kalman::KalmanFilter &kalman_filter)
+void STrack::multi_predict(vector<STrack*> &stracks, kalman::KalmanFilter &kalman_filter, float dt)
 {
 	for (int i = 0; i < stracks.size(); i++)
 	{
@@ -187,6 +190,6 @@ void STrack::multi_predict(vector<STrack*> &stracks, kalman::KalmanFilter &kalma
 		{
 			stracks[i]->mean[7] = 0;
 		}
-		kalman_filter.predict(stracks[i]->mean, stracks[i]->covariance);
+		kalman_filter.predict(stracks[i]->mean, stracks[i]->covariance, dt);
 	}
 }
\ No newline at end of file
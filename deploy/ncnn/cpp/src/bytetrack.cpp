@@ -12,293 +12,728 @@
 #endif
 #include <float.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <vector>
+#include <atomic>
 #include <chrono>
+#include <deque>
+#include <string>
+#include <thread>
 #include "BYTETracker.h"
+#include "cadenceController.h"
+#include "detRecord.h"
+#include "detectorPool.h"
+#include "letterbox.h"
+#include "nms.h"
+#include "reorderBuffer.h"
+#include "roiMosaic.h"
+#include "spscQueue.h"
+#include "traceRecorder.h"
+#include "yoloV5Focus.h"
+#include "yoloxDecoder.h"
 
 #define YOLOX_NMS_THRESH  0.7 // nms threshold
 #define YOLOX_CONF_THRESH 0.1 // threshold of bounding box prob
-#define INPUT_W 1088  // target image size w after resize
-#define INPUT_H 608   // target image size h after resize
-
-Mat static_resize(Mat& img) {
-    float r = min(INPUT_W / (img.cols*1.0), INPUT_H / (img.rows*1.0));
-    // r = std::min(r, 1.0f);
-    int unpad_w = r * img.cols;
-    int unpad_h = r * img.rows;
-    Mat re(unpad_h, unpad_w, CV_8UC3);
-    resize(img, re, re.size());
-    Mat out(INPUT_H, INPUT_W, CV_8UC3, Scalar(114, 114, 114));
-    re.copyTo(out(Rect(0, 0, re.cols, re.rows)));
-    return out;
+#define INPUT_W 1088  // largest network input w, the letterbox scale is that of this size
+#define INPUT_H 608   // largest network input h
+#define INPUT_ALIGN 32 // network input sizes must be multiples of the largest stride
+#define ROI_MAX_AREA 0.6 // a region mosaic larger than this part of the full input is not worth it
+
+// python 0-1 input tensor with rgb_means = (0.485, 0.456, 0.406), std = (0.229, 0.224, 0.225)
+// so for 0-255 input image, rgb_mean should multiply 255 and norm should div by std.
+static const float mean_vals[3] = {255.f * 0.485f, 255.f * 0.456, 255.f * 0.406f};
+static const float norm_vals[3] = {1 / (255.f * 0.229f), 1 / (255.f * 0.224f), 1 / (255.f * 0.225f)};
+
+// The smallest network input that holds a frame letterboxed at the scale of the full
+// INPUT_W x INPUT_H input, rounded up to INPUT_ALIGN. Landscape 16:9 frames still get
+// 1088x608, but 4:3 or portrait streams are no longer padded with gray up to 1088 pixels.
+static Size choose_input_size(int img_w, int img_h)
+{
+    float r = min(INPUT_W / (img_w*1.0), INPUT_H / (img_h*1.0));
+    int input_w = ((int)(r * img_w) + INPUT_ALIGN - 1) / INPUT_ALIGN * INPUT_ALIGN;
+    int input_h = ((int)(r * img_h) + INPUT_ALIGN - 1) / INPUT_ALIGN * INPUT_ALIGN;
+    return Size(min(input_w, INPUT_W), min(input_h, INPUT_H));
 }
 
-// YOLOX use the same focus in yolov5
-class YoloV5Focus : public ncnn::Layer
+static int detect_yolox(ncnn::Mat& in_pad, std::vector<Object>& objects, ncnn::Extractor ex, YoloxDecoder& decoder,
+                        NmsEngine& nms, float scale)
 {
-public:
-    YoloV5Focus()
+
+    ex.input("images", in_pad);
+    
+    ncnn::Mat out;
+    TraceScope inference_trace("inference");
+    ex.extract("output", out);
+    inference_trace.end();
+
+    // a param file exported with a fixed input size keeps its output shape, whatever the input
+    if (out.h != YoloxDecoder::count_anchors(in_pad.w, in_pad.h))
     {
-        one_blob_only = true;
+        fprintf(stderr, "output has %d anchors, expected %d for a %dx%d input, try --fixed-input\n", out.h,
+                YoloxDecoder::count_anchors(in_pad.w, in_pad.h), in_pad.w, in_pad.h);
+        objects.clear();
+        return -1;
     }
 
-    virtual int forward(const ncnn::Mat& bottom_blob, ncnn::Mat& top_blob, const ncnn::Option& opt) const
+    TraceScope decode_trace("decode_outputs");
+    std::vector<Object>& proposals = decoder.decode(out.channel(0), out.w - 5, in_pad.w, in_pad.h, YOLOX_CONF_THRESH);
+    decode_trace.end();
+
+    TRACE_SCOPE("nms");
+    // by score from highest to lowest, with nms_threshold
+    std::vector<int> picked;
+    nms.run(proposals, picked);
+
+    int count = picked.size();
+
+    objects.resize(count);
+    for (int i = 0; i < count; i++)
     {
-        int w = bottom_blob.w;
-        int h = bottom_blob.h;
-        int channels = bottom_blob.c;
+        objects[i] = proposals[picked[i]];
 
-        int outw = w / 2;
-        int outh = h / 2;
-        int outc = channels * 4;
+        // adjust offset to original unpadded
+        float x0 = (objects[i].rect.x) / scale;
+        float y0 = (objects[i].rect.y) / scale;
+        float x1 = (objects[i].rect.x + objects[i].rect.width) / scale;
+        float y1 = (objects[i].rect.y + objects[i].rect.height) / scale;
 
-        top_blob.create(outw, outh, outc, 4u, 1, opt.blob_allocator);
-        if (top_blob.empty())
-            return -100;
+        // clip
+        // x0 = std::max(std::min(x0, (float)(img_w - 1)), 0.f);
+        // y0 = std::max(std::min(y0, (float)(img_h - 1)), 0.f);
+        // x1 = std::max(std::min(x1, (float)(img_w - 1)), 0.f);
+        // y1 = std::max(std::min(y1, (float)(img_h - 1)), 0.f);
 
-        #pragma omp parallel for num_threads(opt.num_threads)
-        for (int p = 0; p < outc; p++)
-        {
-            const float* ptr = bottom_blob.channel(p % channels).row((p / channels) % 2) + ((p / channels) / 2);
-            float* outptr = top_blob.channel(p);
+        objects[i].rect.x = x0;
+        objects[i].rect.y = y0;
+        objects[i].rect.width = x1 - x0;
+        objects[i].rect.height = y1 - y0;
+    }
 
-            for (int i = 0; i < outh; i++)
-            {
-                for (int j = 0; j < outw; j++)
-                {
-                    *outptr = *ptr;
+    return 0;
+}
 
-                    outptr += 1;
-                    ptr += 2;
-                }
+// One line per track in the MOT challenge format, as bytetrack_replay -o writes them.
+static void write_mot(FILE* mot, int frame, const vector<STrack>& output_stracks)
+{
+    for (size_t i = 0; i < output_stracks.size(); i++)
+    {
+        const vector<float>& tlwh = output_stracks[i].tlwh;
+        fprintf(mot, "%d,%d,%.2f,%.2f,%.2f,%.2f,%.2f,-1,-1,-1\n", frame, output_stracks[i].track_id, tlwh[0], tlwh[1],
+                tlwh[2], tlwh[3], output_stracks[i].score);
+    }
+}
 
-                ptr += w;
-            }
+static void draw_tracks(Mat& img, BYTETracker& tracker, const vector<STrack>& output_stracks, int num_frames, int fps)
+{
+    for (size_t i = 0; i < output_stracks.size(); i++)
+    {
+        const vector<float>& tlwh = output_stracks[i].tlwh;
+        bool vertical = tlwh[2] / tlwh[3] > 1.6;
+        if (tlwh[2] * tlwh[3] > 20 && !vertical)
+        {
+            Scalar s = tracker.get_color(output_stracks[i].track_id);
+            putText(img, format("%d", output_stracks[i].track_id), Point(tlwh[0], tlwh[1] - 5), 
+                    0, 0.6, Scalar(0, 0, 255), 2, LINE_AA);
+            rectangle(img, Rect(tlwh[0], tlwh[1], tlwh[2], tlwh[3]), s, 2);
         }
-
-        return 0;
     }
+    putText(img, format("frame: %d fps: %d num: %d", num_frames, fps, (int)output_stracks.size()), 
+            Point(0, 30), 0, 0.6, Scalar(0, 0, 255), 2, LINE_AA);
+}
+
+// One frame on its way through the pipelined runner.
+struct FrameItem
+{
+    int stream;
+    int id;
+    Mat img;
+    ncnn::Mat in_pad;
+    float scale;
+    vector<Object> objects;
+    vector<STrack> output_stracks;
+    chrono::steady_clock::time_point decoded_at;
 };
 
-DEFINE_LAYER_CREATOR(YoloV5Focus)
+// Time a pipeline stage spends working and waiting on its neighbours.
+struct StageStats
+{
+    const char* name;
+    int frames;
+    int64_t busy_us;
+    int64_t wait_in_us;  // blocked on an empty input queue
+    int64_t wait_out_us; // blocked on a full output queue
+};
+
+static int64_t elapsed_us(chrono::steady_clock::time_point since)
+{
+    return chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - since).count();
+}
 
-struct GridAndStride
+// Hands frame n to the n-th queue in turn, so each detector gets every K-th frame.
+class RoundRobin
 {
-    int grid0;
-    int grid1;
-    int stride;
+public:
+    explicit RoundRobin(vector<SpscQueue<FrameItem>*>& queues) : queues(queues) {}
+
+    void push(FrameItem& item)
+    {
+        queues[item.id % queues.size()]->push(item);
+    }
+
+    void close()
+    {
+        for (size_t i = 0; i < queues.size(); i++)
+            queues[i]->close();
+    }
+
+private:
+    vector<SpscQueue<FrameItem>*>& queues;
 };
 
-static inline float intersection_area(const Object& a, const Object& b)
+static void push_frame(SpscQueue<FrameItem>* out, FrameItem& item)
 {
-    cv::Rect_<float> inter = a.rect & b.rect;
-    return inter.area();
+    out->push(item);
 }
 
-static void qsort_descent_inplace(std::vector<Object>& faceobjects, int left, int right)
+static void push_frame(RoundRobin* out, FrameItem& item)
 {
-    int i = left;
-    int j = right;
-    float p = faceobjects[(left + right) / 2].prob;
+    out->push(item);
+}
+
+static void push_frame(ReorderBuffer<FrameItem>* out, FrameItem& item)
+{
+    out->push(item.id, item);
+}
 
-    while (i <= j)
+// Runs one stage on the calling thread: pops from `in` (or produces when `in` is NULL),
+// applies `work` and pushes to `out` (if any) until the input is exhausted.
+template<typename In, typename Out, typename Work>
+static void run_stage(StageStats& stats, In* in, Out* out, Work work)
+{
+    TraceRecorder::set_thread_name(stats.name);
+    for (;;)
     {
-        while (faceobjects[i].prob > p)
-            i++;
+        FrameItem item;
+        chrono::steady_clock::time_point t0 = chrono::steady_clock::now();
+        if (in != NULL && !in->pop(item))
+            break;
+        chrono::steady_clock::time_point t1 = chrono::steady_clock::now();
+        stats.wait_in_us += chrono::duration_cast<chrono::microseconds>(t1 - t0).count();
 
-        while (faceobjects[j].prob < p)
-            j--;
+        bool more = work(item);
+        stats.busy_us += elapsed_us(t1);
+        if (!more)
+            break;
+        stats.frames++;
 
-        if (i <= j)
+        if (out != NULL)
         {
-            // swap
-            std::swap(faceobjects[i], faceobjects[j]);
-
-            i++;
-            j--;
+            chrono::steady_clock::time_point t2 = chrono::steady_clock::now();
+            push_frame(out, item);
+            stats.wait_out_us += elapsed_us(t2);
         }
     }
+    if (out != NULL)
+        out->close();
+}
 
-    #pragma omp parallel sections
+// Decode, preprocess, inference, tracking and render/encode each run on their own thread,
+// connected by bounded SPSC queues, so that e.g. decoding frame n+2 and encoding frame n-1
+// overlap with the inference of frame n. With several detectors, each one runs its own
+// extractor with a share of the threads on every `detectors`-th frame, and a reorder
+// buffer hands their results to the tracker in frame order.
+static int run_pipelined(VideoCapture& cap, ncnn::Net& yolox, BYTETracker& tracker, VideoWriter& writer,
+                         DetRecordWriter& recorder, FILE* mot, Size input_size, size_t queue_size, int detectors,
+                         bool headless)
+{
+    SpscQueue<FrameItem> decoded(queue_size), tracked(queue_size);
+    vector<SpscQueue<FrameItem>*> preprocessed;
+    for (int i = 0; i < detectors; i++)
+        preprocessed.push_back(new SpscQueue<FrameItem>(queue_size));
+    RoundRobin dispatch(preprocessed);
+    // a window of one queue per detector absorbs the usual jitter between them
+    ReorderBuffer<FrameItem> detected(queue_size * detectors, detectors, 1);
+
+    // thread names must outlive the trace recorder
+    static deque<string> inference_names;
+    while ((int)inference_names.size() < detectors)
+        inference_names.push_back(detectors == 1 ? string("inference") : format("inference %d", (int)inference_names.size()));
+
+    vector<StageStats> stats;
+    StageStats decode_stats = {"decode", 0, 0, 0, 0};
+    StageStats preprocess_stats = {"preprocess", 0, 0, 0, 0};
+    stats.push_back(decode_stats);
+    stats.push_back(preprocess_stats);
+    for (int i = 0; i < detectors; i++)
     {
-        #pragma omp section
+        StageStats inference_stats = {inference_names[i].c_str(), 0, 0, 0, 0};
+        stats.push_back(inference_stats);
+    }
+    StageStats track_stats = {"track", 0, 0, 0, 0};
+    StageStats render_stats = {"render", 0, 0, 0, 0};
+    stats.push_back(track_stats);
+    stats.push_back(render_stats);
+    StageStats& track = stats[2 + detectors];
+    StageStats& render = stats[3 + detectors];
+    int threads_per_detector = max(1, yolox.opt.num_threads / detectors);
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    int64_t latency_sum_us = 0;
+    int64_t latency_max_us = 0;
+
+    vector<std::thread> threads;
+    std::atomic<bool> stop(false);
+    threads.push_back(std::thread([&]() {
+        int next_id = 1;
+        run_stage(stats[0], (SpscQueue<FrameItem>*)NULL, &decoded, [&](FrameItem& item) {
+            TraceRecorder::set_frame(next_id);
+            TRACE_SCOPE("decode");
+            item.id = next_id++;
+            item.decoded_at = chrono::steady_clock::now();
+            return !stop.load() && cap.read(item.img) && !item.img.empty();
+        });
+    }));
+    threads.push_back(std::thread([&]() {
+        // one preprocessing thread per detector keeps the stage from starving them
+        LetterboxPreprocessor letterbox(input_size.width, input_size.height, mean_vals, norm_vals);
+        run_stage(stats[1], &decoded, &dispatch, [&](FrameItem& item) {
+            TraceRecorder::set_frame(item.id);
+            TRACE_SCOPE("letterbox");
+            item.scale = letterbox.run(item.img, item.in_pad, detectors);
+            return true;
+        });
+    }));
+    for (int i = 0; i < detectors; i++)
+    {
+        threads.push_back(std::thread([&, i]() {
+            ncnn::Extractor ex = yolox.create_extractor();
+            ex.set_num_threads(threads_per_detector);
+            YoloxDecoder decoder;
+            NmsEngine nms(YOLOX_NMS_THRESH);
+            run_stage(stats[2 + i], preprocessed[i], &detected, [&](FrameItem& item) {
+                TraceRecorder::set_frame(item.id);
+                detect_yolox(item.in_pad, item.objects, ex, decoder, nms, item.scale);
+                item.in_pad.release();
+                return true;
+            });
+        }));
+    }
+    threads.push_back(std::thread([&]() {
+        run_stage(track, &detected, &tracked, [&](FrameItem& item) {
+            TraceRecorder::set_frame(item.id);
+            if (recorder.is_open())
+                recorder.write_frame(item.objects);
+            TraceScope track_trace("track");
+            item.output_stracks = tracker.associate_and_update(item.objects);
+            track_trace.end();
+            if (mot != NULL)
+                write_mot(mot, item.id, item.output_stracks);
+            // the next frame is still in inference: predict for it off the critical path
+            TRACE_SCOPE("predict");
+            tracker.predict_next();
+            return true;
+        });
+    }));
+
+    // render and encode on the main thread, which owns the HighGUI window
+    bool quit = false;
+    run_stage(render, &tracked, (SpscQueue<FrameItem>*)NULL, [&](FrameItem& item) {
+        TraceRecorder::set_frame(item.id);
+        int64_t wall_us = max((int64_t)1, elapsed_us(start));
+        int64_t latency_us = elapsed_us(item.decoded_at);
+        latency_sum_us += latency_us;
+        latency_max_us = max(latency_max_us, latency_us);
+        TraceScope draw_trace("draw");
+        draw_tracks(item.img, tracker, item.output_stracks, item.id, (int)(item.id * 1000000LL / wall_us));
+        draw_trace.end();
+        TraceScope write_trace("write");
+        writer.write(item.img);
+        write_trace.end();
+        if (item.id % 20 == 0)
+            cout << "Processing frame " << item.id << " (" << item.id * 1000000LL / wall_us << " fps)" << endl;
+        if (!headless)
         {
-            if (left < j) qsort_descent_inplace(faceobjects, left, j);
+            imshow("bytetrack", item.img);
+            quit = waitKey(1) > 0;
         }
-        #pragma omp section
+        return !quit;
+    });
+    if (quit)
+    {
+        // stop decoding and drain what is in flight, so the upstream stages can finish
+        stop.store(true);
+        FrameItem item;
+        while (tracked.pop(item))
         {
-            if (i < right) qsort_descent_inplace(faceobjects, i, right);
         }
     }
-}
 
-static void qsort_descent_inplace(std::vector<Object>& objects)
-{
-    if (objects.empty())
-        return;
+    for (size_t i = 0; i < threads.size(); i++)
+        threads[i].join();
 
-    qsort_descent_inplace(objects, 0, objects.size() - 1);
+    int64_t wall_us = max((int64_t)1, elapsed_us(start));
+    int num_frames = render.frames;
+    fprintf(stderr, "%-12s %8s %8s %10s %10s %10s\n", "stage", "frames", "ms/frame", "busy", "wait in", "wait out");
+    for (size_t i = 0; i < stats.size(); i++)
+    {
+        const StageStats& s = stats[i];
+        fprintf(stderr, "%-12s %8d %8.1f %9.1f%% %9.1f%% %9.1f%%\n", s.name, s.frames,
+                s.frames ? s.busy_us / 1000.0 / s.frames : 0.0, 100.0 * s.busy_us / wall_us,
+                100.0 * s.wait_in_us / wall_us, 100.0 * s.wait_out_us / wall_us);
+    }
+    double preprocessed_fill = 0;
+    for (int i = 0; i < detectors; i++)
+        preprocessed_fill += preprocessed[i]->mean_fill() / detectors;
+    fprintf(stderr, "queue fill (of %d): decoded %.1f, preprocessed %.1f, tracked %.1f\n",
+            (int)decoded.capacity(), decoded.mean_fill(), preprocessed_fill, tracked.mean_fill());
+    fprintf(stderr, "reorder buffer (of %d): mean %.1f, max %d frames\n", (int)detected.capacity(),
+            detected.mean_fill(), (int)detected.max_fill());
+    if (num_frames > 0)
+        fprintf(stderr, "latency decode to render: mean %.1f ms, max %.1f ms\n",
+                latency_sum_us / 1000.0 / num_frames, latency_max_us / 1000.0);
+    cout << "FPS: " << num_frames * 1000000LL / wall_us << endl;
+
+    for (int i = 0; i < detectors; i++)
+        delete preprocessed[i];
+    return 0;
 }
 
-static void nms_sorted_bboxes(const std::vector<Object>& faceobjects, std::vector<int>& picked, float nms_threshold)
+// Frame rate the tracker counts its lost-track window in: `fps` when given, else the one of
+// the video. Image sequences have none of their own, and backends report 0, 1 or 25 for
+// them, so below 1 the nominal 30 is taken.
+static int stream_fps(const VideoCapture& cap, int fps)
 {
-    picked.clear();
+    if (fps <= 0)
+        fps = (int)cap.get(CV_CAP_PROP_FPS);
+    return fps > 0 ? fps : 30;
+}
 
-    const int n = faceobjects.size();
+// One of the videos served by serve_streams().
+struct Stream
+{
+    VideoCapture cap;
+    Size input_size;
+    BYTETracker* tracker;
+    ReorderBuffer<FrameItem>* detected;
+    int frames;
+    int64_t tracks;
+};
 
-    std::vector<float> areas(n);
-    for (int i = 0; i < n; i++)
+// Tracks every video in `paths` in this process with the one loaded network: each stream
+// decodes and letterboxes on its own thread at its own input size, a DetectorPool of
+// `detectors` extractors with threads / detectors threads each runs the inferences of all
+// streams, and a reorder buffer per stream hands the detections to that stream's tracker in
+// frame order. Nothing is drawn or written. Stops each stream after `max_frames` frames when
+// that is positive, and returns the frames per second over all the streams. `frame_rate`,
+// when positive, is the frame rate of all the streams.
+static double serve_streams(ncnn::Net& yolox, const vector<const char*>& paths, int detectors, int threads,
+                            size_t queue_size, int max_frames, bool fixed_input, int frame_rate, bool verbose)
+{
+    const int num_streams = (int)paths.size();
+    vector<Stream*> streams;
+    for (int s = 0; s < num_streams; s++)
     {
-        areas[i] = faceobjects[i].rect.area();
+        Stream* stream = new Stream();
+        if (!stream->cap.open(paths[s]))
+        {
+            fprintf(stderr, "Cannot open %s\n", paths[s]);
+            delete stream;
+            continue;
+        }
+        int img_w = stream->cap.get(CV_CAP_PROP_FRAME_WIDTH);
+        int img_h = stream->cap.get(CV_CAP_PROP_FRAME_HEIGHT);
+        stream->input_size = fixed_input ? Size(INPUT_W, INPUT_H) : choose_input_size(img_w, img_h);
+        stream->tracker = new BYTETracker(stream_fps(stream->cap, frame_rate), 30);
+        // a pending queue and one frame per detector may be in flight at once
+        stream->detected = new ReorderBuffer<FrameItem>(queue_size + detectors, 1, 1);
+        stream->frames = 0;
+        stream->tracks = 0;
+        streams.push_back(stream);
     }
-
-    for (int i = 0; i < n; i++)
+    if ((int)streams.size() != num_streams)
     {
-        const Object& a = faceobjects[i];
+        for (size_t s = 0; s < streams.size(); s++)
+            delete streams[s];
+        return 0;
+    }
 
-        int keep = 1;
-        for (int j = 0; j < (int)picked.size(); j++)
+    vector<YoloxDecoder> decoders(detectors);
+    vector<NmsEngine> nms(detectors, NmsEngine(YOLOX_NMS_THRESH));
+    const int threads_per_detector = max(1, threads / detectors);
+    DetectorPool<FrameItem> pool(yolox, num_streams, detectors, threads_per_detector, queue_size,
+                                 [&](ncnn::Extractor& ex, int detector, FrameItem& item) {
+        TraceRecorder::set_frame(item.id);
+        detect_yolox(item.in_pad, item.objects, ex, decoders[detector], nms[detector], item.scale);
+        item.in_pad.release();
+        streams[item.stream]->detected->push(item.id, item);
+    });
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    vector<std::thread> workers;
+    for (int s = 0; s < num_streams; s++)
+    {
+        workers.push_back(std::thread([&, s]() {
+            Stream& stream = *streams[s];
+            LetterboxPreprocessor letterbox(stream.input_size.width, stream.input_size.height, mean_vals, norm_vals);
+            for (int id = 1; max_frames <= 0 || id <= max_frames; id++)
+            {
+                FrameItem item;
+                if (!stream.cap.read(item.img) || item.img.empty())
+                    break;
+                item.stream = s;
+                item.id = id;
+                item.scale = letterbox.run(item.img, item.in_pad, 1);
+                item.img.release();
+                pool.submit(item);
+            }
+            pool.wait_idle(s);
+            stream.detected->close();
+        }));
+        workers.push_back(std::thread([&, s]() {
+            Stream& stream = *streams[s];
+            FrameItem item;
+            while (stream.detected->pop(item))
+            {
+                vector<STrack> output_stracks = stream.tracker->update(item.objects);
+                stream.frames++;
+                stream.tracks += output_stracks.size();
+            }
+        }));
+    }
+    for (size_t i = 0; i < workers.size(); i++)
+        workers[i].join();
+    pool.close();
+    int64_t wall_us = max((int64_t)1, elapsed_us(start));
+
+    int total_frames = 0;
+    for (int s = 0; s < num_streams; s++)
+        total_frames += streams[s]->frames;
+    double fps = total_frames * 1000000.0 / wall_us;
+    if (verbose)
+    {
+        fprintf(stderr, "%-8s %-10s %8s %8s %8s\n", "stream", "input", "frames", "FPS", "tracks");
+        for (int s = 0; s < num_streams; s++)
         {
-            const Object& b = faceobjects[picked[j]];
-
-            // intersection over union
-            float inter_area = intersection_area(a, b);
-            float union_area = areas[i] + areas[picked[j]] - inter_area;
-            // float IoU = inter_area / union_area
-            if (inter_area / union_area > nms_threshold)
-                keep = 0;
+            const Stream& stream = *streams[s];
+            fprintf(stderr, "%-8d %4dx%-5d %8d %8.1f %8.1f\n", s, stream.input_size.width, stream.input_size.height,
+                    stream.frames, stream.frames * 1000000.0 / wall_us,
+                    stream.frames ? (double)stream.tracks / stream.frames : 0.0);
         }
+        for (int i = 0; i < detectors; i++)
+            fprintf(stderr, "detector %d: %d frames, busy %.1f%%\n", i, pool.detector_frame_count(i),
+                    100.0 * pool.detector_busy_us(i) / wall_us);
+        fprintf(stderr, "%d streams on %d detectors x %d threads: %.1f FPS, %.1f FPS per stream, %.2f FPS per core\n",
+                num_streams, detectors, threads_per_detector, fps, fps / num_streams,
+                fps / (detectors * threads_per_detector));
+    }
 
-        if (keep)
-            picked.push_back(i);
+    for (int s = 0; s < num_streams; s++)
+    {
+        delete streams[s]->tracker;
+        delete streams[s]->detected;
+        delete streams[s];
     }
+    return fps;
 }
 
-static void generate_grids_and_stride(const int target_w, const int target_h, std::vector<int>& strides, std::vector<GridAndStride>& grid_strides)
+// Throughput of serve_streams() on 1, 2, 4, ... cores, each split every way into
+// detectors x threads per detector, so a deployment can pick the split and the number of
+// streams per machine. The decoding and tracking threads come on top.
+static void sweep_cores(ncnn::Net& yolox, const vector<const char*>& paths, size_t queue_size, int frames,
+                        bool fixed_input, int frame_rate)
 {
-    for (int i = 0; i < (int)strides.size(); i++)
+    int cores = ncnn::get_cpu_count();
+    vector<int> core_counts;
+    for (int c = 1; c < cores; c *= 2)
+        core_counts.push_back(c);
+    core_counts.push_back(cores);
+
+    printf("%d streams, %d frames each\n", (int)paths.size(), frames);
+    printf("cores  detectors x threads  total FPS  FPS/stream  FPS/core\n");
+    for (size_t i = 0; i < core_counts.size(); i++)
     {
-        int stride = strides[i];
-        int num_grid_w = target_w / stride;
-        int num_grid_h = target_h / stride;
-        for (int g1 = 0; g1 < num_grid_h; g1++)
+        int c = core_counts[i];
+        for (int t = 1; t <= c; t *= 2)
         {
-            for (int g0 = 0; g0 < num_grid_w; g0++)
-            {
-                GridAndStride gs;
-                gs.grid0 = g0;
-                gs.grid1 = g1;
-                gs.stride = stride;
-                grid_strides.push_back(gs);
-            }
+            if (c % t != 0)
+                continue;
+            double fps = serve_streams(yolox, paths, c / t, c, queue_size, frames, fixed_input, frame_rate, false);
+            printf("%5d  %9d x %-7d  %9.1f  %10.1f  %8.2f\n", c, c / t, t, fps, fps / paths.size(), fps / c);
         }
     }
 }
 
-static void generate_yolox_proposals(std::vector<GridAndStride> grid_strides, const ncnn::Mat& feat_blob, float prob_threshold, std::vector<Object>& objects)
+static void usage(const char* prog)
 {
-    const int num_grid = feat_blob.h;
-    const int num_class = feat_blob.w - 5;
-    const int num_anchors = grid_strides.size();
+    fprintf(stderr, "Usage: %s [videopath] [detections.btdr] [options]\n", prog);
+    fprintf(stderr, "  --pipeline     run decode, preprocess, inference, tracking and rendering on separate threads\n");
+    fprintf(stderr, "  --queue <n>    frames buffered between pipeline stages (4)\n");
+    fprintf(stderr, "  --detectors <k> run k detectors on consecutive frames at once, implies --pipeline (1)\n");
+    fprintf(stderr, "  --threads <n>  inference threads, shared by the detectors (20)\n");
+    fprintf(stderr, "  --headless     no window, no waitKey\n");
+    fprintf(stderr, "  --int8         load the quantized bytetrack_s_op-int8.param/.bin (see bytetrack_calibrate)\n");
+    fprintf(stderr, "  --mot <file>   write the tracks in MOT challenge format\n");
+    fprintf(stderr, "  --fixed-input  always run the network at %dx%d, for param files with a fixed input size\n", INPUT_W, INPUT_H);
+    fprintf(stderr, "  --stream <video> serve this video too, from the same network (repeatable): the videos are\n"
+                    "                 tracked without display or output, --detectors extractors run all their\n"
+                    "                 frames, and the throughput of each stream is printed\n");
+    fprintf(stderr, "  --frames <n>   with --stream, stop each stream after n frames\n");
+    fprintf(stderr, "  --sweep-cores [n] serve n frames of every stream on 1, 2, 4, ... cores with each split\n"
+                    "                 into detectors x threads and print the throughput, then exit (100)\n");
+    fprintf(stderr, "  --cadence <n|auto> run the detector on every n-th frame, or on the frames the cadence\n"
+                    "                 controller picks from track motion, crowding and --budget-ms, and carry\n"
+                    "                 the tracks through the others with the Kalman filter (1)\n");
+    fprintf(stderr, "  --max-interval <n> longest interval of --cadence auto (4)\n");
+    fprintf(stderr, "  --budget-ms <ms> processing time per frame --cadence auto keeps within (none)\n");
+    fprintf(stderr, "  --roi <n>      detect the whole frame on every n-th detection only, and on the others a\n"
+                    "                 mosaic of the regions around the predicted tracks and one edge strip\n");
+    fprintf(stderr, "  --realtime     play the video as a live camera: drop the frames processing is already late\n"
+                    "                 for, and track with the frame timestamps so the gaps are predicted over\n");
+    fprintf(stderr, "  --fps <rate>   frame rate of the input, for image sequences, which carry none (the video's, or 30)\n");
+    fprintf(stderr, "  --bench-input [n] time n inferences at the fixed and the fitted input size of common\n"
+                    "                 camera resolutions, then exit (20)\n");
+}
 
-    const float* feat_ptr = feat_blob.channel(0);
-    for (int anchor_idx = 0; anchor_idx < num_anchors; anchor_idx++)
+// Inference time at the fixed INPUT_W x INPUT_H input against the input chosen by
+// choose_input_size(), for the camera resolutions we deploy on.
+static void bench_input_sizes(ncnn::Net& yolox, int iterations)
+{
+    static const int cameras[][2] = {{1920, 1080}, {1280, 720}, {2560, 1440}, {1280, 960}, {640, 480},
+                                     {2048, 1536}, {1080, 1920}, {720, 1280}, {1024, 1024}};
+    LetterboxPreprocessor fixed_letterbox(INPUT_W, INPUT_H, mean_vals, norm_vals);
+
+    printf("camera      input           ms  fitted          ms   saved\n");
+    for (size_t i = 0; i < sizeof(cameras) / sizeof(cameras[0]); i++)
     {
-        const int grid0 = grid_strides[anchor_idx].grid0;
-        const int grid1 = grid_strides[anchor_idx].grid1;
-        const int stride = grid_strides[anchor_idx].stride;
-
-        // yolox/models/yolo_head.py decode logic
-        //  outputs[..., :2] = (outputs[..., :2] + grids) * strides
-        //  outputs[..., 2:4] = torch.exp(outputs[..., 2:4]) * strides
-        float x_center = (feat_ptr[0] + grid0) * stride;
-        float y_center = (feat_ptr[1] + grid1) * stride;
-        float w = exp(feat_ptr[2]) * stride;
-        float h = exp(feat_ptr[3]) * stride;
-        float x0 = x_center - w * 0.5f;
-        float y0 = y_center - h * 0.5f;
-
-        float box_objectness = feat_ptr[4];
-        for (int class_idx = 0; class_idx < num_class; class_idx++)
+        Mat img(cameras[i][1], cameras[i][0], CV_8UC3, Scalar(114, 114, 114));
+        Size input_size = choose_input_size(img.cols, img.rows);
+        LetterboxPreprocessor fitted_letterbox(input_size.width, input_size.height, mean_vals, norm_vals);
+
+        double ms[2];
+        for (int k = 0; k < 2; k++)
         {
-            float box_cls_score = feat_ptr[5 + class_idx];
-            float box_prob = box_objectness * box_cls_score;
-            if (box_prob > prob_threshold)
+            ncnn::Mat in;
+            (k == 0 ? fixed_letterbox : fitted_letterbox).run(img, in, yolox.opt.num_threads);
+            // the first run allocates and packs the weights for this shape
+            for (int n = -1; n < iterations; n++)
             {
-                Object obj;
-                obj.rect.x = x0;
-                obj.rect.y = y0;
-                obj.rect.width = w;
-                obj.rect.height = h;
-                obj.label = class_idx;
-                obj.prob = box_prob;
-
-                objects.push_back(obj);
+                if (n == 0)
+                    ms[k] = 0;
+                chrono::steady_clock::time_point start = chrono::steady_clock::now();
+                ncnn::Extractor ex = yolox.create_extractor();
+                ncnn::Mat out;
+                ex.input("images", in);
+                ex.extract("output", out);
+                ms[k] += chrono::duration<double, std::milli>(chrono::steady_clock::now() - start).count();
             }
-
-        } // class loop
-        feat_ptr += feat_blob.w;
-
-    } // point anchor loop
+            ms[k] /= iterations;
+        }
+        printf("%4dx%-4d   %4dx%-4d %8.1f  %4dx%-4d %9.1f  %5.1f%%\n", img.cols, img.rows, INPUT_W, INPUT_H, ms[0],
+               input_size.width, input_size.height, ms[1], 100.0 * (1.0 - ms[1] / ms[0]));
+    }
 }
 
-static int detect_yolox(ncnn::Mat& in_pad, std::vector<Object>& objects, ncnn::Extractor ex, float scale)
+int main(int argc, char** argv)
 {
-
-    ex.input("images", in_pad);
-    
-    std::vector<Object> proposals;
-
+    const char* videopath = NULL;
+    const char* recordpath = NULL;
+    bool pipelined = false;
+    bool headless = false;
+    size_t queue_size = 4;
+    int detectors = 1;
+    int num_threads = 20;
+    bool fixed_input = false;
+    bool int8 = false;
+    const char* motpath = NULL;
+    int bench_iterations = 0;
+    vector<const char*> extra_streams;
+    int max_frames = 0;
+    int sweep_frames = 0;
+    int detect_every = 1;
+    bool adaptive = false;
+    CadenceConfig cadence_config;
+    int roi_every = 1;
+    bool realtime = false;
+    int fps_override = 0;
+    for (int i = 1; i < argc; i++)
     {
-        ncnn::Mat out;
-        ex.extract("output", out);
-
-        static const int stride_arr[] = {8, 16, 32}; // might have stride=64 in YOLOX
-        std::vector<int> strides(stride_arr, stride_arr + sizeof(stride_arr) / sizeof(stride_arr[0]));
-        std::vector<GridAndStride> grid_strides;
-        generate_grids_and_stride(INPUT_W, INPUT_H, strides, grid_strides);
-        generate_yolox_proposals(grid_strides, out, YOLOX_CONF_THRESH, proposals);
+        if (strcmp(argv[i], "--pipeline") == 0)
+            pipelined = true;
+        else if (strcmp(argv[i], "--headless") == 0)
+            headless = true;
+        else if (strcmp(argv[i], "--queue") == 0 && i + 1 < argc)
+            queue_size = max(1, atoi(argv[++i]));
+        else if (strcmp(argv[i], "--detectors") == 0 && i + 1 < argc)
+        {
+            detectors = max(1, atoi(argv[++i]));
+            pipelined = true;
+        }
+        else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+            num_threads = max(1, atoi(argv[++i]));
+        else if (strcmp(argv[i], "--int8") == 0)
+            int8 = true;
+        else if (strcmp(argv[i], "--mot") == 0 && i + 1 < argc)
+            motpath = argv[++i];
+        else if (strcmp(argv[i], "--fixed-input") == 0)
+            fixed_input = true;
+        else if (strcmp(argv[i], "--stream") == 0 && i + 1 < argc)
+            extra_streams.push_back(argv[++i]);
+        else if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc)
+            max_frames = max(1, atoi(argv[++i]));
+        else if (strcmp(argv[i], "--sweep-cores") == 0)
+            sweep_frames = i + 1 < argc && argv[i + 1][0] != '-' && atoi(argv[i + 1]) > 0 ? atoi(argv[++i]) : 100;
+        else if (strcmp(argv[i], "--cadence") == 0 && i + 1 < argc)
+        {
+            adaptive = strcmp(argv[++i], "auto") == 0;
+            detect_every = adaptive ? 1 : max(1, atoi(argv[i]));
+        }
+        else if (strcmp(argv[i], "--max-interval") == 0 && i + 1 < argc)
+            cadence_config.max_interval = max(1, atoi(argv[++i]));
+        else if (strcmp(argv[i], "--budget-ms") == 0 && i + 1 < argc)
+            cadence_config.budget_ms = atof(argv[++i]);
+        else if (strcmp(argv[i], "--roi") == 0 && i + 1 < argc)
+            roi_every = max(1, atoi(argv[++i]));
+        else if (strcmp(argv[i], "--realtime") == 0)
+            realtime = true;
+        else if (strcmp(argv[i], "--fps") == 0 && i + 1 < argc)
+            fps_override = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--bench-input") == 0)
+            bench_iterations = i + 1 < argc && argv[i + 1][0] != '-' && atoi(argv[i + 1]) > 0 ? atoi(argv[++i]) : 20;
+        else if (argv[i][0] != '-' && videopath == NULL)
+            videopath = argv[i];
+        else if (argv[i][0] != '-' && recordpath == NULL)
+            recordpath = argv[i];
+        else
+        {
+            usage(argv[0]);
+            return -1;
+        }
     }
-    // sort all proposals by score from highest to lowest
-    qsort_descent_inplace(proposals);
-
-    // apply nms with nms_threshold
-    std::vector<int> picked;
-    nms_sorted_bboxes(proposals, picked, YOLOX_NMS_THRESH);
-
-    int count = picked.size();
-
-    objects.resize(count);
-    for (int i = 0; i < count; i++)
+    if (videopath == NULL && bench_iterations == 0)
     {
-        objects[i] = proposals[picked[i]];
-
-        // adjust offset to original unpadded
-        float x0 = (objects[i].rect.x) / scale;
-        float y0 = (objects[i].rect.y) / scale;
-        float x1 = (objects[i].rect.x + objects[i].rect.width) / scale;
-        float y1 = (objects[i].rect.y + objects[i].rect.height) / scale;
-
-        // clip
-        // x0 = std::max(std::min(x0, (float)(img_w - 1)), 0.f);
-        // y0 = std::max(std::min(y0, (float)(img_h - 1)), 0.f);
-        // x1 = std::max(std::min(x1, (float)(img_w - 1)), 0.f);
-        // y1 = std::max(std::min(y1, (float)(img_h - 1)), 0.f);
-
-        objects[i].rect.x = x0;
-        objects[i].rect.y = y0;
-        objects[i].rect.width = x1 - x0;
-        objects[i].rect.height = y1 - y0;
+        usage(argv[0]);
+        return -1;
     }
-
-    return 0;
-}
-
-int main(int argc, char** argv)
-{
-    if (argc != 2)
+    const bool cadence_on = adaptive || detect_every > 1;
+    if ((cadence_on || roi_every > 1) && (pipelined || !extra_streams.empty() || sweep_frames > 0))
+    {
+        fprintf(stderr, "--cadence and --roi decide per frame from the tracks of the last one, so they only run on the sequential loop\n");
+        return -1;
+    }
+    if (realtime && (pipelined || !extra_streams.empty() || sweep_frames > 0 || recordpath != NULL))
+    {
+        fprintf(stderr, "--realtime drops frames on the sequential loop, and does not record detections\n");
+        return -1;
+    }
+    if (roi_every > 1 && fixed_input)
+    {
+        fprintf(stderr, "--roi runs the network at the size of each mosaic, it needs a param file without a fixed input size\n");
+        return -1;
+    }
+    if (cadence_on && recordpath != NULL)
     {
-        fprintf(stderr, "Usage: %s [videopath]\n", argv[0]);
+        fprintf(stderr, "record the detections of every frame and simulate the cadence with bytetrack_replay --cadence\n");
         return -1;
     }
 
@@ -306,7 +741,7 @@ int main(int argc, char** argv)
 
     //yolox.opt.use_vulkan_compute = true;
     //yolox.opt.use_bf16_storage = true;
-    yolox.opt.num_threads = 20;
+    yolox.opt.num_threads = num_threads;
     //ncnn::set_cpu_powersave(0);
 
     //ncnn::set_omp_dynamic(0);
@@ -315,82 +750,236 @@ int main(int argc, char** argv)
     // Focus in yolov5
     yolox.register_custom_layer("YoloV5Focus", YoloV5Focus_layer_creator);
 
-    yolox.load_param("bytetrack_s_op.param");
-    yolox.load_model("bytetrack_s_op.bin");
-    
-    ncnn::Extractor ex = yolox.create_extractor();
+    // the int8 model comes from ncnn2int8 with the table of bytetrack_calibrate; ncnn runs
+    // the quantized convolutions in int8 and the rest of the network in fp32
+    yolox.opt.use_int8_inference = true;
+    const char* model = int8 ? "bytetrack_s_op-int8" : "bytetrack_s_op";
+    if (yolox.load_param(format("%s.param", model).c_str()) != 0 || yolox.load_model(format("%s.bin", model).c_str()) != 0)
+    {
+        fprintf(stderr, "Cannot load %s.param/.bin\n", model);
+        return -1;
+    }
+
+    if (bench_iterations > 0)
+    {
+        bench_input_sizes(yolox, bench_iterations);
+        return 0;
+    }
 
-    const char* videopath = argv[1];
+    if (!extra_streams.empty() || sweep_frames > 0)
+    {
+        vector<const char*> paths(1, videopath);
+        paths.insert(paths.end(), extra_streams.begin(), extra_streams.end());
+        if (sweep_frames > 0)
+            sweep_cores(yolox, paths, queue_size, sweep_frames, fixed_input, fps_override);
+        else
+        {
+            double fps = serve_streams(yolox, paths, detectors, num_threads, queue_size, max_frames, fixed_input,
+                                       fps_override, true);
+            cout << "FPS: " << (int)fps << endl;
+        }
+        return 0;
+    }
 
     VideoCapture cap(videopath);
-	if (!cap.isOpened())
-		return 0;
+    if (!cap.isOpened())
+        return 0;
 
-	int img_w = cap.get(CV_CAP_PROP_FRAME_WIDTH);
-	int img_h = cap.get(CV_CAP_PROP_FRAME_HEIGHT);
-    int fps = cap.get(CV_CAP_PROP_FPS);
+    int img_w = cap.get(CV_CAP_PROP_FRAME_WIDTH);
+    int img_h = cap.get(CV_CAP_PROP_FRAME_HEIGHT);
+    int fps = stream_fps(cap, fps_override);
     long nFrame = static_cast<long>(cap.get(CV_CAP_PROP_FRAME_COUNT));
     cout << "Total frames: " << nFrame << endl;
+    Size input_size = fixed_input ? Size(INPUT_W, INPUT_H) : choose_input_size(img_w, img_h);
+    cout << "Network input: " << input_size.width << "x" << input_size.height << endl;
 
     VideoWriter writer("demo.mp4", CV_FOURCC('m', 'p', '4', 'v'), fps, Size(img_w, img_h));
 
-    Mat img;
+    // optionally record the detections for offline replay with bytetrack_replay
+    DetRecordWriter recorder;
+    if (recordpath != NULL && !recorder.open(recordpath, fps, img_w, img_h))
+        return -1;
+    FILE* mot = NULL;
+    if (motpath != NULL && (mot = fopen(motpath, "w")) == NULL)
+    {
+        fprintf(stderr, "Cannot write %s\n", motpath);
+        return -1;
+    }
+
+    // BYTETRACK_TRACE=<trace.json> records a timeline of the pipeline stages
+    const char* trace_path = getenv("BYTETRACK_TRACE");
+    if (trace_path != NULL)
+    {
+        TraceRecorder::start();
+        TraceRecorder::set_thread_name("pipeline");
+    }
+
     BYTETracker tracker(fps, 30);
+    if (pipelined)
+    {
+        run_pipelined(cap, yolox, tracker, writer, recorder, mot, input_size, queue_size, detectors, headless);
+        cap.release();
+        recorder.close();
+        if (mot != NULL)
+            fclose(mot);
+        if (trace_path != NULL)
+            TraceRecorder::dump(trace_path);
+        return 0;
+    }
+
+    ncnn::Extractor ex = yolox.create_extractor();
+    LetterboxPreprocessor letterbox(input_size.width, input_size.height, mean_vals, norm_vals);
+    ncnn::Mat in_pad;
+    YoloxDecoder decoder;
+    NmsEngine nms(YOLOX_NMS_THRESH);
+
+    CadenceController cadence(cadence_config);
+    int detected_frames = 0;
+
+    // the mosaic crops are resized at the scale of the full-frame letterbox
+    RoiMosaic roi(input_size.width, INPUT_ALIGN);
+    const float full_scale = min(input_size.width / (img_w * 1.f), input_size.height / (img_h * 1.f));
+    const int full_area = input_size.width * input_size.height;
+    vector<Rect_<float> > roi_boxes;
+    int roi_edge = 0;
+    int roi_frames = 0;
+    int64_t roi_area = 0;
+
+    // --realtime: wall clock at the stream time 0, and the timestamps of the frames
+    chrono::steady_clock::time_point stream_start;
+    const double frame_period = 1.0 / fps;
+    double timestamp = 0;
+    int dropped_frames = 0;
+
+    Mat img;
     int num_frames = 0;
-    int total_ms = 1;
-	for (;;)
+    int64_t total_us = 1;
+    for (;;)
     {
+        TraceRecorder::set_frame(num_frames + 1);
+        TRACE_SCOPE("frame");
+        TraceScope decode_trace("decode");
         if(!cap.read(img))
             break;
+        decode_trace.end();
         num_frames ++;
         if (num_frames % 20 == 0)
         {
-            cout << "Processing frame " << num_frames << " (" << num_frames * 1000000 / total_ms << " fps)" << endl;
+            cout << "Processing frame " << num_frames << " (" << num_frames * 1000000LL / total_us << " fps)" << endl;
         }
-		if (img.empty())
-			break;
+        if (img.empty())
+            break;
 
-        float scale = min(INPUT_W / (img.cols*1.0), INPUT_H / (img.rows*1.0));
-        Mat pr_img = static_resize(img);
-        ncnn::Mat in_pad = ncnn::Mat::from_pixels_resize(pr_img.data, ncnn::Mat::PIXEL_BGR2RGB, INPUT_W, INPUT_H, INPUT_W, INPUT_H);
-    
-        // python 0-1 input tensor with rgb_means = (0.485, 0.456, 0.406), std = (0.229, 0.224, 0.225)
-        // so for 0-255 input image, rgb_mean should multiply 255 and norm should div by std.
-        const float mean_vals[3] = {255.f * 0.485f, 255.f * 0.456, 255.f * 0.406f};
-        const float norm_vals[3] = {1 / (255.f * 0.229f), 1 / (255.f * 0.224f), 1 / (255.f * 0.225f)};
-
-        in_pad.substract_mean_normalize(mean_vals, norm_vals);
-
-        std::vector<Object> objects;
-        auto start = chrono::system_clock::now();
-        //detect_yolox(img, objects);
-        detect_yolox(in_pad, objects, ex, scale);
-        vector<STrack> output_stracks = tracker.update(objects);
-        auto end = chrono::system_clock::now();
-        total_ms = total_ms + chrono::duration_cast<chrono::microseconds>(end - start).count();
-        for (int i = 0; i < output_stracks.size(); i++)
-		{
-			vector<float> tlwh = output_stracks[i].tlwh;
-			bool vertical = tlwh[2] / tlwh[3] > 1.6;
-			if (tlwh[2] * tlwh[3] > 20 && !vertical)
-			{
-				Scalar s = tracker.get_color(output_stracks[i].track_id);
-				putText(img, format("%d", output_stracks[i].track_id), Point(tlwh[0], tlwh[1] - 5), 
-                        0, 0.6, Scalar(0, 0, 255), 2, LINE_AA);
-                rectangle(img, Rect(tlwh[0], tlwh[1], tlwh[2], tlwh[3]), s, 2);
-			}
-		}
-        putText(img, format("frame: %d fps: %d num: %d", num_frames, num_frames * 1000000 / total_ms, output_stracks.size()), 
-                Point(0, 30), 0, 0.6, Scalar(0, 0, 255), 2, LINE_AA);
+        if (realtime)
+        {
+            // image sequences have no timestamps, their frames come at the nominal rate
+            double stream_time = cap.get(CV_CAP_PROP_POS_MSEC) / 1000.0;
+            timestamp = num_frames == 1 ? stream_time
+                                         : (stream_time > timestamp ? stream_time : timestamp + frame_period);
+            if (num_frames == 1)
+                stream_start = chrono::steady_clock::now() - chrono::microseconds((int64_t)(timestamp * 1e6));
+            // a camera waits for nobody: shed the frames we are more than a frame period late for,
+            // and wait for the ones that would not have arrived yet
+            double late = elapsed_us(stream_start) / 1e6 - timestamp;
+            if (late > frame_period)
+            {
+                dropped_frames++;
+                continue;
+            }
+            if (late < 0)
+                this_thread::sleep_for(chrono::microseconds((int64_t)(-late * 1e6)));
+            tracker.predict_next(timestamp);
+        }
+
+        // on the frames between detections the Kalman filter alone carries the tracks
+        bool detect = adaptive ? cadence.should_detect() : (num_frames - 1) % detect_every == 0;
+        auto frame_start = chrono::steady_clock::now();
+        vector<STrack> output_stracks;
+        if (detect)
+        {
+            // between full-frame passes, only where the tracks are expected and one edge strip in turn
+            bool use_roi = false;
+            if (roi_every > 1 && detected_frames % roi_every != 0)
+            {
+                TRACE_SCOPE("roi_plan");
+                tracker.predicted_boxes(roi_boxes);
+                use_roi = !roi_boxes.empty()
+                          && roi.plan(roi_boxes, img_w, img_h, full_scale, roi_edge, full_area, ROI_MAX_AREA);
+            }
+
+            float scale = 1.f;
+            if (use_roi)
+            {
+                TRACE_SCOPE("mosaic");
+                roi.build(img, in_pad, mean_vals, norm_vals);
+                roi_edge = (roi_edge + 1) % 4;
+                roi_frames++;
+                roi_area += roi.width() * roi.height();
+            }
+            else
+            {
+                TraceScope letterbox_trace("letterbox");
+                scale = letterbox.run(img, in_pad, yolox.opt.num_threads);
+                letterbox_trace.end();
+            }
+
+            std::vector<Object> objects;
+            auto start = chrono::steady_clock::now();
+            //detect_yolox(img, objects);
+            detect_yolox(in_pad, objects, ex, decoder, nms, scale);
+            if (use_roi)
+                roi.map_back(objects);
+            if (recorder.is_open())
+                recorder.write_frame(objects);
+            TraceScope track_trace("track");
+            output_stracks = realtime ? tracker.update(objects, timestamp) : tracker.update(objects);
+            track_trace.end();
+            auto end = chrono::steady_clock::now();
+            total_us = total_us + chrono::duration_cast<chrono::microseconds>(end - start).count();
+            detected_frames++;
+        }
+        else
+        {
+            auto start = chrono::steady_clock::now();
+            TraceScope track_trace("predict");
+            output_stracks = realtime ? tracker.predict_only(timestamp) : tracker.predict_only();
+            track_trace.end();
+            total_us = total_us + elapsed_us(start);
+        }
+        if (adaptive)
+            cadence.observe(output_stracks, detect, elapsed_us(frame_start) / 1000.0);
+        if (mot != NULL)
+            write_mot(mot, num_frames, output_stracks);
+        TraceScope draw_trace("draw");
+        draw_tracks(img, tracker, output_stracks, num_frames, (int)(num_frames * 1000000LL / total_us));
+        draw_trace.end();
+        TraceScope write_trace("write");
         writer.write(img);
-        char c = waitKey(1);
-        if (c > 0)
+        write_trace.end();
+        if (!headless)
         {
-            break;
+            char c = waitKey(1);
+            if (c > 0)
+            {
+                break;
+            }
         }
     }
     cap.release();
-    cout << "FPS: " << num_frames * 1000000 / total_ms << endl;
+    recorder.close();
+    if (mot != NULL)
+        fclose(mot);
+    if (trace_path != NULL)
+        TraceRecorder::dump(trace_path);
+    if (roi_every > 1)
+        fprintf(stderr, "Detected %d of %d frames on region mosaics, %.1f%% of the full input on average\n", roi_frames,
+                detected_frames, roi_frames > 0 ? 100.0 * roi_area / roi_frames / full_area : 0.0);
+    if (realtime)
+        fprintf(stderr, "Dropped %d of %d frames to keep up with the stream\n", dropped_frames, num_frames);
+    if (cadence_on)
+        fprintf(stderr, "Detected %d of %d frames, one every %.2f\n", detected_frames, num_frames,
+                (double)num_frames / max(detected_frames, 1));
+    cout << "FPS: " << num_frames * 1000000LL / total_us << endl;
 
     return 0;
 }
@@ -0,0 +1,78 @@
+#include "detRecord.h"
+
+#include <string.h>
+
+DetRecordWriter::DetRecordWriter()
+    : file(NULL)
+{
+    memset(&header, 0, sizeof(header));
+}
+
+DetRecordWriter::~DetRecordWriter()
+{
+    close();
+}
+
+bool DetRecordWriter::open(const std::string& path, int frame_rate, int img_w, int img_h)
+{
+    close();
+    file = fopen(path.c_str(), "wb");
+    if (file == NULL)
+    {
+        fprintf(stderr, "Cannot open detection record %s for writing\n", path.c_str());
+        return false;
+    }
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, DET_RECORD_MAGIC, sizeof(header.magic));
+    header.version = DET_RECORD_VERSION;
+    header.frame_rate = frame_rate;
+    header.img_w = img_w;
+    header.img_h = img_h;
+
+    offsets.clear();
+    offsets.push_back(0);
+
+    // the header is rewritten with the final counts on close()
+    return fwrite(&header, sizeof(header), 1, file) == 1;
+}
+
+bool DetRecordWriter::write_frame(const std::vector<Object>& objects)
+{
+    if (file == NULL)
+        return false;
+
+    boxes.resize(objects.size());
+    for (size_t i = 0; i < objects.size(); i++)
+    {
+        boxes[i].x = objects[i].rect.x;
+        boxes[i].y = objects[i].rect.y;
+        boxes[i].w = objects[i].rect.width;
+        boxes[i].h = objects[i].rect.height;
+        boxes[i].prob = objects[i].prob;
+        boxes[i].label = objects[i].label;
+    }
+    if (!boxes.empty() && fwrite(&boxes[0], sizeof(DetRecordBox), boxes.size(), file) != boxes.size())
+        return false;
+
+    header.num_boxes += boxes.size();
+    header.num_frames++;
+    offsets.push_back(header.num_boxes);
+    return true;
+}
+
+bool DetRecordWriter::close()
+{
+    if (file == NULL)
+        return true;
+
+    header.offsets_pos = sizeof(DetRecordHeader) + header.num_boxes * sizeof(DetRecordBox);
+    bool ok = fwrite(&offsets[0], sizeof(uint64_t), offsets.size(), file) == offsets.size();
+    ok = ok && fseek(file, 0, SEEK_SET) == 0;
+    ok = ok && fwrite(&header, sizeof(header), 1, file) == 1;
+    ok = (fclose(file) == 0) && ok;
+    file = NULL;
+    if (!ok)
+        fprintf(stderr, "Failed to finalize detection record\n");
+    return ok;
+}
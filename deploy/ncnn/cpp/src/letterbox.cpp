@@ -0,0 +1,173 @@
+#include "letterbox.h"
+
+#include <math.h>
+#include <algorithm>
+
+// cv::resize keeps the bilinear weights in 11 bits, so a horizontally resized value is the
+// 8-bit pixel times 2^11 and the vertical pass brings it back with a 22 bit shift.
+static const int COEF_BITS = 11;
+static const int COEF_SCALE = 1 << COEF_BITS;
+
+static int16_t fixed_coef(float value)
+{
+    return (int16_t)lrintf(value * COEF_SCALE);
+}
+
+// Vertical blend of two horizontally resized values, as the SIMD path of cv::resize does
+// it: 16 bit multiply-high of the values reduced to 16 bits, then a rounding shift.
+static inline int blend_rows(int32_t upper, int32_t lower, int16_t b0, int16_t b1)
+{
+    int v = (((int16_t)(upper >> 4) * b0) >> 16) + (((int16_t)(lower >> 4) * b1) >> 16);
+    v = (v + 2) >> 2;
+    return v < 0 ? 0 : (v > 255 ? 255 : v);
+}
+
+LetterboxPreprocessor::LetterboxPreprocessor(int dst_w, int dst_h, const float mean_vals[3],
+                                             const float norm_vals[3], int pad_value)
+    : dst_w(dst_w), dst_h(dst_h), src_w(0), src_h(0), unpad_w(0), unpad_h(0), scale(1.f)
+{
+    for (int c = 0; c < 3; c++)
+    {
+        norm[c] = norm_vals[c];
+        bias[c] = -mean_vals[c] * norm_vals[c];
+        pad_values[c] = pad_value * norm[c] + bias[c];
+    }
+}
+
+void LetterboxPreprocessor::prepare(int width, int height, int threads)
+{
+    size_t scratch_size = (size_t)threads * 2 * dst_w * 3;
+    if (scratch.size() < scratch_size)
+        scratch.resize(scratch_size);
+    if (width == src_w && height == src_h)
+        return;
+
+    src_w = width;
+    src_h = height;
+    double r = std::min(dst_w / (width * 1.0), dst_h / (height * 1.0));
+    scale = r;
+    unpad_w = std::min(dst_w, (int)(r * width));
+    unpad_h = std::min(dst_h, (int)(r * height));
+
+    // same sampling positions and border handling as cv::resize
+    double scale_x = (double)width / unpad_w;
+    x_ofs.resize(2 * unpad_w);
+    x_coef.resize(2 * unpad_w);
+    for (int dx = 0; dx < unpad_w; dx++)
+    {
+        float fx = (float)((dx + 0.5) * scale_x - 0.5);
+        int sx = (int)floorf(fx);
+        fx -= sx;
+        if (sx < 0)
+        {
+            fx = 0;
+            sx = 0;
+        }
+        if (sx >= width - 1)
+        {
+            fx = 0;
+            sx = width - 1;
+        }
+        x_ofs[2 * dx] = sx * 3;
+        x_ofs[2 * dx + 1] = std::min(sx + 1, width - 1) * 3;
+        x_coef[2 * dx] = fixed_coef(1.f - fx);
+        x_coef[2 * dx + 1] = fixed_coef(fx);
+    }
+
+    double scale_y = (double)height / unpad_h;
+    y_ofs.resize(unpad_h);
+    y_coef.resize(2 * unpad_h);
+    for (int dy = 0; dy < unpad_h; dy++)
+    {
+        float fy = (float)((dy + 0.5) * scale_y - 0.5);
+        int sy = (int)floorf(fy);
+        fy -= sy;
+        y_ofs[dy] = sy;
+        y_coef[2 * dy] = fixed_coef(1.f - fy);
+        y_coef[2 * dy + 1] = fixed_coef(fy);
+    }
+}
+
+// Resizes one source row horizontally into three planes in RGB order.
+void LetterboxPreprocessor::resize_row(const cv::Mat& bgr, int src_row, int32_t* out) const
+{
+    const uint8_t* src = bgr.ptr<uint8_t>(std::max(0, std::min(src_row, src_h - 1)));
+    int32_t* r = out;
+    int32_t* g = out + unpad_w;
+    int32_t* b = out + 2 * unpad_w;
+    for (int dx = 0; dx < unpad_w; dx++)
+    {
+        const uint8_t* left = src + x_ofs[2 * dx];
+        const uint8_t* right = src + x_ofs[2 * dx + 1];
+        int a0 = x_coef[2 * dx];
+        int a1 = x_coef[2 * dx + 1];
+        b[dx] = left[0] * a0 + right[0] * a1;
+        g[dx] = left[1] * a0 + right[1] * a1;
+        r[dx] = left[2] * a0 + right[2] * a1;
+    }
+}
+
+void LetterboxPreprocessor::process_rows(const cv::Mat& bgr, ncnn::Mat& in, int begin, int end, int32_t* rows) const
+{
+    // the two source rows of the previous output row, reused when they are needed again
+    int32_t* upper = rows;
+    int32_t* lower = rows + dst_w * 3;
+    int upper_row = -2, lower_row = -2;
+
+    for (int y = begin; y < end; y++)
+    {
+        float* out[3] = {in.channel(0).row(y), in.channel(1).row(y), in.channel(2).row(y)};
+        int x0 = 0;
+        if (y < unpad_h)
+        {
+            int r0 = std::max(0, std::min(y_ofs[y], src_h - 1));
+            int r1 = std::max(0, std::min(y_ofs[y] + 1, src_h - 1));
+            if (r0 == lower_row)
+            {
+                std::swap(upper, lower);
+                upper_row = lower_row;
+                lower_row = -2;
+            }
+            if (r0 != upper_row)
+            {
+                resize_row(bgr, r0, upper);
+                upper_row = r0;
+            }
+            if (r1 != lower_row)
+            {
+                resize_row(bgr, r1, lower);
+                lower_row = r1;
+            }
+
+            // plane by plane, so that the compiler vectorizes the blend and the normalization
+            const int16_t b0 = y_coef[2 * y], b1 = y_coef[2 * y + 1];
+            for (int c = 0; c < 3; c++)
+            {
+                const int32_t* u = upper + c * unpad_w;
+                const int32_t* l = lower + c * unpad_w;
+                const float n = norm[c], b = bias[c];
+                float* o = out[c];
+                for (int x = 0; x < unpad_w; x++)
+                    o[x] = blend_rows(u[x], l[x], b0, b1) * n + b;
+            }
+            x0 = unpad_w;
+        }
+        for (int c = 0; c < 3; c++)
+            std::fill(out[c] + x0, out[c] + dst_w, pad_values[c]);
+    }
+}
+
+float LetterboxPreprocessor::run(const cv::Mat& bgr, ncnn::Mat& in, int threads)
+{
+    threads = std::max(1, std::min(threads, dst_h));
+    prepare(bgr.cols, bgr.rows, threads);
+    in.create(dst_w, dst_h, 3);
+
+    #pragma omp parallel for num_threads(threads)
+    for (int t = 0; t < threads; t++)
+    {
+        process_rows(bgr, in, dst_h * t / threads, dst_h * (t + 1) / threads,
+                     &scratch[(size_t)t * 2 * dst_w * 3]);
+    }
+    return scale;
+}
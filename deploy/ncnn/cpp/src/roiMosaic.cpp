@@ -0,0 +1,145 @@
+#include "roiMosaic.h"
+
+#include <math.h>
+#include <algorithm>
+
+// margin around a predicted box, relative to its height, and at least MIN_MARGIN pixels:
+// the prediction drifts, and the detector needs some context around an object
+static const float ROI_MARGIN = 0.5f;
+static const float MIN_MARGIN = 16.f;
+// depth of the edge strips, relative to the frame width or height
+static const float EDGE_STRIP = 0.1f;
+// gray between two crops in the mosaic, so that no box spans two of them
+static const int GAP = 16;
+
+RoiMosaic::RoiMosaic(int max_w, int align, int pad_value)
+    : max_w(max_w), align(align), pad_value(pad_value), mosaic_w(0), mosaic_h(0)
+{
+}
+
+bool RoiMosaic::plan(const std::vector<cv::Rect_<float> >& boxes, int img_w, int img_h, float scale, int edge,
+                     int full_area, float max_fraction)
+{
+    const cv::Rect frame(0, 0, img_w, img_h);
+    regions.clear();
+    for (size_t i = 0; i < boxes.size(); i++)
+    {
+        const cv::Rect_<float>& b = boxes[i];
+        float m = std::max(ROI_MARGIN * b.height, MIN_MARGIN);
+        int x0 = (int)floorf(b.x - m);
+        int y0 = (int)floorf(b.y - m);
+        int x1 = (int)ceilf(b.x + b.width + m);
+        int y1 = (int)ceilf(b.y + b.height + m);
+        cv::Rect r = cv::Rect(x0, y0, x1 - x0, y1 - y0) & frame;
+        if (r.area() > 0)
+            regions.push_back(r);
+    }
+    int strip_w = std::max(1, (int)(EDGE_STRIP * img_w));
+    int strip_h = std::max(1, (int)(EDGE_STRIP * img_h));
+    if (edge == 0)
+        regions.push_back(cv::Rect(0, 0, strip_w, img_h));
+    else if (edge == 1)
+        regions.push_back(cv::Rect(0, 0, img_w, strip_h));
+    else if (edge == 2)
+        regions.push_back(cv::Rect(img_w - strip_w, 0, strip_w, img_h));
+    else if (edge == 3)
+        regions.push_back(cv::Rect(0, img_h - strip_h, img_w, strip_h));
+
+    // merge overlapping regions until none overlap: an object seen by two crops would be
+    // detected twice
+    bool merged = true;
+    while (merged)
+    {
+        merged = false;
+        for (size_t i = 0; i < regions.size(); i++)
+        {
+            for (size_t j = i + 1; j < regions.size(); j++)
+            {
+                if ((regions[i] & regions[j]).area() == 0)
+                    continue;
+                regions[i] |= regions[j];
+                regions[j] = regions.back();
+                regions.pop_back();
+                j = i; // the grown region may now overlap one already checked
+                merged = true;
+            }
+        }
+    }
+
+    // shelf packing, tallest crops first
+    order.resize(regions.size());
+    for (size_t i = 0; i < order.size(); i++)
+        order[i] = (int)i;
+    std::sort(order.begin(), order.end(), [this](int a, int b) { return regions[a].height > regions[b].height; });
+    crops.clear();
+    slots.clear();
+    int x = 0, y = 0, shelf_h = 0;
+    mosaic_w = 0;
+    for (size_t k = 0; k < order.size(); k++)
+    {
+        const cv::Rect& crop = regions[order[k]];
+        int sw = std::min(max_w, std::max(1, (int)ceilf(crop.width * scale)));
+        int sh = std::max(1, (int)ceilf(crop.height * scale));
+        if (x > 0 && x + sw > max_w)
+        {
+            y += shelf_h + GAP;
+            x = 0;
+            shelf_h = 0;
+        }
+        crops.push_back(crop);
+        slots.push_back(cv::Rect(x, y, sw, sh));
+        mosaic_w = std::max(mosaic_w, x + sw);
+        shelf_h = std::max(shelf_h, sh);
+        x += sw + GAP;
+    }
+    mosaic_h = y + shelf_h;
+    mosaic_w = (mosaic_w + align - 1) / align * align;
+    mosaic_h = (mosaic_h + align - 1) / align * align;
+    return !crops.empty() && mosaic_w * mosaic_h <= max_fraction * full_area;
+}
+
+void RoiMosaic::build(const cv::Mat& bgr, ncnn::Mat& in, const float mean_vals[3], const float norm_vals[3])
+{
+    canvas.create(mosaic_h, mosaic_w, CV_8UC3);
+    canvas.setTo(cv::Scalar(pad_value, pad_value, pad_value));
+    for (size_t i = 0; i < crops.size(); i++)
+    {
+        // resizes in place, into the part of the canvas the slot covers
+        cv::Mat slot = canvas(slots[i]);
+        cv::resize(bgr(crops[i]), slot, slot.size(), 0, 0, cv::INTER_LINEAR);
+    }
+    in = ncnn::Mat::from_pixels(canvas.data, ncnn::Mat::PIXEL_BGR2RGB, mosaic_w, mosaic_h);
+    in.substract_mean_normalize(mean_vals, norm_vals);
+}
+
+void RoiMosaic::map_back(std::vector<Object>& objects) const
+{
+    size_t kept = 0;
+    for (size_t i = 0; i < objects.size(); i++)
+    {
+        cv::Rect_<float>& r = objects[i].rect;
+        float cx = r.x + r.width * 0.5f;
+        float cy = r.y + r.height * 0.5f;
+        size_t t = 0;
+        while (t < slots.size() && !(cx >= slots[t].x && cx < slots[t].x + slots[t].width && cy >= slots[t].y
+                                     && cy < slots[t].y + slots[t].height))
+            t++;
+        if (t == slots.size())
+            continue;
+
+        const cv::Rect& slot = slots[t];
+        const cv::Rect& crop = crops[t];
+        float sx = (float)crop.width / slot.width;
+        float sy = (float)crop.height / slot.height;
+        float x0 = std::max(r.x, (float)slot.x);
+        float y0 = std::max(r.y, (float)slot.y);
+        float x1 = std::min(r.x + r.width, (float)(slot.x + slot.width));
+        float y1 = std::min(r.y + r.height, (float)(slot.y + slot.height));
+        r.x = crop.x + (x0 - slot.x) * sx;
+        r.y = crop.y + (y0 - slot.y) * sy;
+        r.width = (x1 - x0) * sx;
+        r.height = (y1 - y0) * sy;
+        objects[kept++] = objects[i];
+    }
+    objects.resize(kept);
+}
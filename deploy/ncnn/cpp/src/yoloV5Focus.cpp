@@ -0,0 +1,321 @@
+#include "yoloV5Focus.h"
+
+#include <algorithm>
+
+#if __ARM_NEON
+#include <arm_neon.h>
+#endif
+#if __SSE2__
+#include <emmintrin.h>
+#endif
+#if __AVX2__
+#include <immintrin.h>
+#endif
+
+// pixels per lane and block of the packed path, kept on the stack
+static const int PACKED_BLOCK = 64;
+
+// even[i] = src[2 * i], odd[i] = src[2 * i + 1] for i < n
+static void deinterleave(const float* src, float* even, float* odd, int n)
+{
+    int i = 0;
+#if __ARM_NEON
+    for (; i + 3 < n; i += 4)
+    {
+        float32x4x2_t v = vld2q_f32(src + i * 2);
+        vst1q_f32(even + i, v.val[0]);
+        vst1q_f32(odd + i, v.val[1]);
+    }
+#else
+#if __AVX2__
+    for (; i + 7 < n; i += 8)
+    {
+        __m256 a = _mm256_loadu_ps(src + i * 2);
+        __m256 b = _mm256_loadu_ps(src + i * 2 + 8);
+        // the shuffles work within 128 bit lanes, the permute puts the halves in order
+        __m256 e = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+        __m256 o = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+        _mm256_storeu_ps(even + i, _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(e), _MM_SHUFFLE(3, 1, 2, 0))));
+        _mm256_storeu_ps(odd + i, _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(o), _MM_SHUFFLE(3, 1, 2, 0))));
+    }
+#endif
+#if __SSE2__
+    for (; i + 3 < n; i += 4)
+    {
+        __m128 a = _mm_loadu_ps(src + i * 2);
+        __m128 b = _mm_loadu_ps(src + i * 2 + 4);
+        _mm_storeu_ps(even + i, _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+        _mm_storeu_ps(odd + i, _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+    }
+#endif
+#endif
+    for (; i < n; i++)
+    {
+        even[i] = src[i * 2];
+        odd[i] = src[i * 2 + 1];
+    }
+}
+
+// fp16 / bf16
+static void deinterleave(const unsigned short* src, unsigned short* even, unsigned short* odd, int n)
+{
+    int i = 0;
+#if __ARM_NEON
+    for (; i + 7 < n; i += 8)
+    {
+        uint16x8x2_t v = vld2q_u16(src + i * 2);
+        vst1q_u16(even + i, v.val[0]);
+        vst1q_u16(odd + i, v.val[1]);
+    }
+#elif __SSE2__
+    for (; i + 7 < n; i += 8)
+    {
+        __m128i a = _mm_loadu_si128((const __m128i*)(src + i * 2));
+        __m128i b = _mm_loadu_si128((const __m128i*)(src + i * 2 + 8));
+        // sign-extended to 32 bits, the 16 bit values pass the saturating pack unchanged
+        __m128i e = _mm_packs_epi32(_mm_srai_epi32(_mm_slli_epi32(a, 16), 16), _mm_srai_epi32(_mm_slli_epi32(b, 16), 16));
+        __m128i o = _mm_packs_epi32(_mm_srai_epi32(a, 16), _mm_srai_epi32(b, 16));
+        _mm_storeu_si128((__m128i*)(even + i), e);
+        _mm_storeu_si128((__m128i*)(odd + i), o);
+    }
+#endif
+    for (; i < n; i++)
+    {
+        even[i] = src[i * 2];
+        odd[i] = src[i * 2 + 1];
+    }
+}
+
+// out[i * elempack + l] = lanes[l][i] for i < n, four lanes at a time
+static void interleave(const float* const* lanes, int elempack, float* out, int n)
+{
+    for (int l0 = 0; l0 < elempack; l0 += 4)
+    {
+        const float* a = lanes[l0];
+        const float* b = lanes[l0 + 1];
+        const float* c = lanes[l0 + 2];
+        const float* d = lanes[l0 + 3];
+        float* outptr = out + l0;
+        int i = 0;
+#if __ARM_NEON
+        if (elempack == 4)
+        {
+            for (; i + 3 < n; i += 4)
+            {
+                float32x4x4_t v;
+                v.val[0] = vld1q_f32(a + i);
+                v.val[1] = vld1q_f32(b + i);
+                v.val[2] = vld1q_f32(c + i);
+                v.val[3] = vld1q_f32(d + i);
+                vst4q_f32(outptr + i * 4, v);
+            }
+        }
+#elif __SSE2__
+        for (; i + 3 < n; i += 4)
+        {
+            __m128 v0 = _mm_loadu_ps(a + i);
+            __m128 v1 = _mm_loadu_ps(b + i);
+            __m128 v2 = _mm_loadu_ps(c + i);
+            __m128 v3 = _mm_loadu_ps(d + i);
+            _MM_TRANSPOSE4_PS(v0, v1, v2, v3);
+            _mm_storeu_ps(outptr + i * elempack, v0);
+            _mm_storeu_ps(outptr + (i + 1) * elempack, v1);
+            _mm_storeu_ps(outptr + (i + 2) * elempack, v2);
+            _mm_storeu_ps(outptr + (i + 3) * elempack, v3);
+        }
+#endif
+        for (; i < n; i++)
+        {
+            outptr[i * elempack] = a[i];
+            outptr[i * elempack + 1] = b[i];
+            outptr[i * elempack + 2] = c[i];
+            outptr[i * elempack + 3] = d[i];
+        }
+    }
+}
+
+static void interleave(const unsigned short* const* lanes, int elempack, unsigned short* out, int n)
+{
+    for (int l0 = 0; l0 < elempack; l0 += 4)
+    {
+        const unsigned short* a = lanes[l0];
+        const unsigned short* b = lanes[l0 + 1];
+        const unsigned short* c = lanes[l0 + 2];
+        const unsigned short* d = lanes[l0 + 3];
+        unsigned short* outptr = out + l0;
+        int i = 0;
+#if __ARM_NEON
+        if (elempack == 4)
+        {
+            for (; i + 3 < n; i += 4)
+            {
+                uint16x4x4_t v;
+                v.val[0] = vld1_u16(a + i);
+                v.val[1] = vld1_u16(b + i);
+                v.val[2] = vld1_u16(c + i);
+                v.val[3] = vld1_u16(d + i);
+                vst4_u16(outptr + i * 4, v);
+            }
+        }
+#elif __SSE2__
+        for (; i + 7 < n; i += 8)
+        {
+            __m128i ab = _mm_unpacklo_epi16(_mm_loadu_si128((const __m128i*)(a + i)), _mm_loadu_si128((const __m128i*)(b + i)));
+            __m128i ab_hi = _mm_unpackhi_epi16(_mm_loadu_si128((const __m128i*)(a + i)), _mm_loadu_si128((const __m128i*)(b + i)));
+            __m128i cd = _mm_unpacklo_epi16(_mm_loadu_si128((const __m128i*)(c + i)), _mm_loadu_si128((const __m128i*)(d + i)));
+            __m128i cd_hi = _mm_unpackhi_epi16(_mm_loadu_si128((const __m128i*)(c + i)), _mm_loadu_si128((const __m128i*)(d + i)));
+            // two pixels of four lanes each
+            __m128i p[4];
+            p[0] = _mm_unpacklo_epi32(ab, cd);
+            p[1] = _mm_unpackhi_epi32(ab, cd);
+            p[2] = _mm_unpacklo_epi32(ab_hi, cd_hi);
+            p[3] = _mm_unpackhi_epi32(ab_hi, cd_hi);
+            for (int k = 0; k < 4; k++)
+            {
+                if (elempack == 4)
+                {
+                    _mm_storeu_si128((__m128i*)(outptr + (i + k * 2) * 4), p[k]);
+                    continue;
+                }
+                _mm_storel_epi64((__m128i*)(outptr + (i + k * 2) * elempack), p[k]);
+                _mm_storel_epi64((__m128i*)(outptr + (i + k * 2 + 1) * elempack), _mm_unpackhi_epi64(p[k], p[k]));
+            }
+        }
+#endif
+        for (; i < n; i++)
+        {
+            outptr[i * elempack] = a[i];
+            outptr[i * elempack + 1] = b[i];
+            outptr[i * elempack + 2] = c[i];
+            outptr[i * elempack + 3] = d[i];
+        }
+    }
+}
+
+// One input row pair per iteration: each row is read once and split straight into the
+// rows of its two phases.
+template<typename T>
+static void focus_pack1(const ncnn::Mat& bottom_blob, ncnn::Mat& top_blob, const ncnn::Option& opt)
+{
+    const int channels = bottom_blob.c;
+    const int outw = top_blob.w;
+    const int outh = top_blob.h;
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int n = 0; n < channels * outh; n++)
+    {
+        const int q = n / outh;
+        const int i = n % outh;
+        for (int r = 0; r < 2; r++)
+        {
+            const T* ptr = bottom_blob.channel(q).row<const T>(i * 2 + r);
+            T* even = top_blob.channel(r * channels + q).row<T>(i);
+            T* odd = top_blob.channel((2 + r) * channels + q).row<T>(i);
+            deinterleave(ptr, even, odd, outw);
+        }
+    }
+}
+
+// Each lane of an output row comes from its own input row and column phase: the rows are
+// split in blocks on the stack, then the lanes are interleaved into the packed layout.
+template<typename T>
+static void focus_packed(const ncnn::Mat& bottom_blob, ncnn::Mat& top_blob, const ncnn::Option& opt)
+{
+    const int channels = bottom_blob.c;
+    const int outw = top_blob.w;
+    const int outh = top_blob.h;
+    const int elempack = top_blob.elempack;
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int n = 0; n < top_blob.c * outh; n++)
+    {
+        const int g = n / outh;
+        const int i = n % outh;
+        T* outptr = top_blob.channel(g).row<T>(i);
+
+        T split[8][2][PACKED_BLOCK];
+        const T* rows[8];
+        const T* lanes[8];
+        for (int l = 0; l < elempack; l++)
+        {
+            const int p = g * elempack + l;
+            const int phase = p / channels;
+            rows[l] = bottom_blob.channel(p % channels).row<const T>(i * 2 + phase % 2);
+            lanes[l] = split[l][phase / 2];
+        }
+
+        for (int j = 0; j < outw; j += PACKED_BLOCK)
+        {
+            const int block = std::min(PACKED_BLOCK, outw - j);
+            for (int l = 0; l < elempack; l++)
+                deinterleave(rows[l] + j * 2, split[l][0], split[l][1], block);
+            interleave(lanes, elempack, outptr + j * elempack, block);
+        }
+    }
+}
+
+YoloV5Focus::YoloV5Focus()
+{
+    one_blob_only = true;
+    support_packing = true;
+    support_fp16_storage = true;
+    support_bf16_storage = true;
+}
+
+int YoloV5Focus::forward(const ncnn::Mat& bottom_blob, ncnn::Mat& top_blob, const ncnn::Option& opt) const
+{
+    // the 3 channel network input always comes in pack1, other inputs are unpacked first
+    ncnn::Mat bottom = bottom_blob;
+    if (bottom_blob.elempack != 1)
+    {
+        ncnn::Option opt_pack1 = opt;
+        opt_pack1.blob_allocator = opt.workspace_allocator;
+        ncnn::convert_packing(bottom_blob, bottom, 1, opt_pack1);
+    }
+
+    int w = bottom.w;
+    int h = bottom.h;
+    int channels = bottom.c;
+    size_t elemsize = bottom.elemsize;
+
+    int outw = w / 2;
+    int outh = h / 2;
+    int outc = channels * 4;
+
+    // the packing the next layer would convert to
+    int out_elempack = 1;
+    if (opt.use_packing_layout)
+    {
+#if __AVX__
+        if (outc % 8 == 0)
+            out_elempack = 8;
+#endif
+#if __ARM_NEON || __SSE2__
+        if (out_elempack == 1 && outc % 4 == 0)
+            out_elempack = 4;
+#endif
+    }
+
+    top_blob.create(outw, outh, outc / out_elempack, elemsize * out_elempack, out_elempack, opt.blob_allocator);
+    if (top_blob.empty())
+        return -100;
+
+    if (elemsize == 2u)
+    {
+        if (out_elempack == 1)
+            focus_pack1<unsigned short>(bottom, top_blob, opt);
+        else
+            focus_packed<unsigned short>(bottom, top_blob, opt);
+    }
+    else
+    {
+        if (out_elempack == 1)
+            focus_pack1<float>(bottom, top_blob, opt);
+        else
+            focus_packed<float>(bottom, top_blob, opt);
+    }
+
+    return 0;
+}
+
+DEFINE_LAYER_CREATOR(YoloV5Focus)
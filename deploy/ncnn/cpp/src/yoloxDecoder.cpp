@@ -0,0 +1,116 @@
+#include "yoloxDecoder.h"
+
+#include <math.h>
+#include <algorithm>
+
+static const int strides_arr[] = {8, 16, 32}; // might have stride=64 in YOLOX
+
+YoloxDecoder::YoloxDecoder()
+    : input_w(0), input_h(0)
+{
+}
+
+int YoloxDecoder::count_anchors(int input_w, int input_h)
+{
+    int count = 0;
+    for (size_t i = 0; i < sizeof(strides_arr) / sizeof(strides_arr[0]); i++)
+        count += (input_w / strides_arr[i]) * (input_h / strides_arr[i]);
+    return count;
+}
+
+void YoloxDecoder::prepare(int input_w, int input_h)
+{
+    if (input_w == this->input_w && input_h == this->input_h)
+        return;
+    this->input_w = input_w;
+    this->input_h = input_h;
+
+    grid_x.clear();
+    grid_y.clear();
+    strides.clear();
+    for (size_t i = 0; i < sizeof(strides_arr) / sizeof(strides_arr[0]); i++)
+    {
+        int stride = strides_arr[i];
+        int num_grid_w = input_w / stride;
+        int num_grid_h = input_h / stride;
+        for (int g1 = 0; g1 < num_grid_h; g1++)
+        {
+            for (int g0 = 0; g0 < num_grid_w; g0++)
+            {
+                grid_x.push_back(g0);
+                grid_y.push_back(g1);
+                strides.push_back(stride);
+            }
+        }
+    }
+    scores.resize(grid_x.size());
+    candidates.resize(grid_x.size());
+}
+
+std::vector<Object>& YoloxDecoder::decode(const float* feat, int num_classes, int input_w, int input_h,
+                                          float prob_threshold)
+{
+    prepare(input_w, input_h);
+    const int num_anchors = grid_x.size();
+    const int row = num_classes + 5;
+
+    // objectness * best class score; the scores are probabilities, so the best product is
+    // the product with the best score
+    if (num_classes == 1)
+    {
+        for (int i = 0; i < num_anchors; i++)
+            scores[i] = feat[i * 6 + 4] * feat[i * 6 + 5];
+    }
+    else
+    {
+        for (int i = 0; i < num_anchors; i++)
+        {
+            const float* p = feat + (size_t)i * row;
+            float best = p[5];
+            for (int c = 1; c < num_classes; c++)
+                best = std::max(best, p[5 + c]);
+            scores[i] = p[4] * best;
+        }
+    }
+
+    // branch-free compaction of the anchors that pass
+    int count = 0;
+    for (int i = 0; i < num_anchors; i++)
+    {
+        candidates[count] = i;
+        count += scores[i] > prob_threshold;
+    }
+
+    proposals.clear();
+    for (int k = 0; k < count; k++)
+    {
+        const int i = candidates[k];
+        const float* p = feat + (size_t)i * row;
+        const float stride = strides[i];
+
+        // yolox/models/yolo_head.py decode logic
+        //  outputs[..., :2] = (outputs[..., :2] + grids) * strides
+        //  outputs[..., 2:4] = torch.exp(outputs[..., 2:4]) * strides
+        float x_center = (p[0] + grid_x[i]) * stride;
+        float y_center = (p[1] + grid_y[i]) * stride;
+        float w = expf(p[2]) * stride;
+        float h = expf(p[3]) * stride;
+
+        Object obj;
+        obj.rect.x = x_center - w * 0.5f;
+        obj.rect.y = y_center - h * 0.5f;
+        obj.rect.width = w;
+        obj.rect.height = h;
+        for (int c = 0; c < num_classes; c++)
+        {
+            float box_prob = p[4] * p[5 + c];
+            if (box_prob > prob_threshold)
+            {
+                obj.label = c;
+                obj.prob = box_prob;
+                proposals.push_back(obj);
+            }
+        }
+    }
+    return proposals;
+}
@@ -0,0 +1,347 @@
+#include "layer.h"
+#include "net.h"
+#include "layer/convolution.h"
+#include "layer/convolutiondepthwise.h"
+#include "layer/innerproduct.h"
+
+#include <opencv2/opencv.hpp>
+#include <float.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include "letterbox.h"
+#include "yoloV5Focus.h"
+
+// Builds the ncnn int8 calibration table of the ByteTrack model from frames of our own
+// videos, so that the activation ranges are those of the scenes the model will see. It
+// does what ncnn2table does with method=kl, but loads the YoloV5Focus layer and feeds the
+// frames through the same letterbox and normalization as the demo. The table then goes to
+// ncnn2int8:
+//
+//   bytetrack_calibrate bytetrack_s_op.param bytetrack_s_op.bin bytetrack_s.table cam1.mp4 cam2.mp4
+//   ncnn2int8 bytetrack_s_op.param bytetrack_s_op.bin bytetrack_s_op-int8.param bytetrack_s_op-int8.bin bytetrack_s.table
+
+#define INPUT_W 1088
+#define INPUT_H 608
+#define NUM_HISTOGRAM_BINS 2048
+#define NUM_QUANTIZE_BINS 128
+
+// same normalization as src/bytetrack.cpp
+static const float mean_vals[3] = {255.f * 0.485f, 255.f * 0.456, 255.f * 0.406f};
+static const float norm_vals[3] = {1 / (255.f * 0.229f), 1 / (255.f * 0.224f), 1 / (255.f * 0.225f)};
+
+struct QuantLayer
+{
+    const ncnn::Layer* layer;
+    int bottom;
+    std::vector<float> weight_scales;
+    float absmax;
+    std::vector<float> histogram;
+    float bottom_scale;
+};
+
+static void usage(const char* prog)
+{
+    fprintf(stderr, "Usage: %s <model.param> <model.bin> <out.table> <video> [video ...] [options]\n", prog);
+    fprintf(stderr, "  -n <frames>    frames sampled evenly over all the videos (200)\n");
+    fprintf(stderr, "  -t <threads>   inference threads (4)\n");
+}
+
+// Per output channel (per group for depthwise), 127 over the largest absolute weight.
+static std::vector<float> weight_scales(const ncnn::Layer* layer)
+{
+    ncnn::Mat weight_data;
+    int channels = 1;
+    if (layer->type == "Convolution")
+    {
+        weight_data = ((const ncnn::Convolution*)layer)->weight_data;
+        channels = ((const ncnn::Convolution*)layer)->num_output;
+    }
+    else if (layer->type == "ConvolutionDepthWise")
+    {
+        weight_data = ((const ncnn::ConvolutionDepthWise*)layer)->weight_data;
+        channels = ((const ncnn::ConvolutionDepthWise*)layer)->group;
+    }
+    else
+    {
+        weight_data = ((const ncnn::InnerProduct*)layer)->weight_data;
+        channels = ((const ncnn::InnerProduct*)layer)->num_output;
+    }
+
+    std::vector<float> scales(channels);
+    const int size = weight_data.w / channels;
+    const float* weights = weight_data;
+    for (int c = 0; c < channels; c++)
+    {
+        float absmax = 0.f;
+        for (int i = 0; i < size; i++)
+            absmax = std::max(absmax, fabsf(weights[c * size + i]));
+        scales[c] = absmax == 0.f ? 1.f : 127 / absmax;
+    }
+    return scales;
+}
+
+// Calls f(blob) with the input blob of every frame sampled from the videos, in order.
+template<typename F>
+static bool for_each_frame(const std::vector<const char*>& videos, int frames, F f)
+{
+    LetterboxPreprocessor letterbox(INPUT_W, INPUT_H, mean_vals, norm_vals);
+    ncnn::Mat in;
+    const int per_video = (frames + (int)videos.size() - 1) / (int)videos.size();
+    for (size_t v = 0; v < videos.size(); v++)
+    {
+        cv::VideoCapture cap(videos[v]);
+        if (!cap.isOpened())
+        {
+            fprintf(stderr, "Cannot open %s\n", videos[v]);
+            return false;
+        }
+        long count = (long)cap.get(cv::CAP_PROP_FRAME_COUNT);
+        long step = std::max(1L, count / per_video);
+        cv::Mat img;
+        int taken = 0;
+        for (long i = 0; taken < per_video && cap.read(img) && !img.empty(); i++)
+        {
+            if (i % step != 0)
+                continue;
+            letterbox.run(img, in, 1);
+            f(in);
+            taken++;
+        }
+    }
+    return true;
+}
+
+static float kl_divergence(const std::vector<float>& p, const std::vector<float>& q)
+{
+    float result = 0.f;
+    for (size_t i = 0; i < p.size(); i++)
+    {
+        if (p[i] == 0.f)
+            continue;
+        // bins that the quantized distribution cannot represent cost as much as a tiny q
+        result += p[i] * logf(p[i] / std::max(q[i], 1e-8f));
+    }
+    return result;
+}
+
+// Activation threshold that minimizes the KL divergence between the clipped histogram and
+// its 128-level quantization, as in ncnn2table (method=kl) and TensorRT.
+static float kl_threshold_bin(const std::vector<float>& histogram)
+{
+    float kl_min = FLT_MAX;
+    int best = NUM_HISTOGRAM_BINS;
+    std::vector<float> clip(NUM_HISTOGRAM_BINS), quantized(NUM_QUANTIZE_BINS), expanded(NUM_HISTOGRAM_BINS);
+    for (int threshold = NUM_QUANTIZE_BINS; threshold < NUM_HISTOGRAM_BINS; threshold++)
+    {
+        // the reference: everything above the threshold lands in the last bin
+        clip.assign(histogram.begin(), histogram.begin() + threshold);
+        for (int i = threshold; i < NUM_HISTOGRAM_BINS; i++)
+            clip[threshold - 1] += histogram[i];
+
+        // the candidate: the unclipped bins merged into 128 levels, each level spread back over
+        // its non-empty bins, so that the outliers it drops count against it
+        const float bins_per_level = (float)threshold / NUM_QUANTIZE_BINS;
+        expanded.assign(threshold, 0.f);
+        for (int q = 0; q < NUM_QUANTIZE_BINS; q++)
+        {
+            const float start = q * bins_per_level;
+            const float end = start + bins_per_level;
+            const int left_upper = (int)ceilf(start);
+            const int right_lower = (int)floorf(end);
+            const float left_scale = left_upper - start;
+            const float right_scale = end - right_lower;
+
+            float sum = 0.f, count = 0.f;
+            if (left_upper > start && histogram[left_upper - 1] != 0.f)
+            {
+                sum += left_scale * histogram[left_upper - 1];
+                count += left_scale;
+            }
+            if (right_lower < end && right_lower < threshold && histogram[right_lower] != 0.f)
+            {
+                sum += right_scale * histogram[right_lower];
+                count += right_scale;
+            }
+            for (int j = left_upper; j < right_lower; j++)
+            {
+                if (histogram[j] != 0.f)
+                {
+                    sum += histogram[j];
+                    count += 1.f;
+                }
+            }
+            quantized[q] = count == 0.f ? 0.f : sum / count;
+
+            if (left_upper > start && histogram[left_upper - 1] != 0.f)
+                expanded[left_upper - 1] += quantized[q] * left_scale;
+            if (right_lower < end && right_lower < threshold && histogram[right_lower] != 0.f)
+                expanded[right_lower] += quantized[q] * right_scale;
+            for (int j = left_upper; j < right_lower; j++)
+            {
+                if (histogram[j] != 0.f)
+                    expanded[j] += quantized[q];
+            }
+        }
+
+        float clip_sum = 0.f, expanded_sum = 0.f;
+        for (int i = 0; i < threshold; i++)
+        {
+            clip_sum += clip[i];
+            expanded_sum += expanded[i];
+        }
+        if (clip_sum == 0.f || expanded_sum == 0.f)
+            continue;
+        for (int i = 0; i < threshold; i++)
+        {
+            clip[i] /= clip_sum;
+            expanded[i] /= expanded_sum;
+        }
+
+        float kl = kl_divergence(clip, expanded);
+        if (kl < kl_min)
+        {
+            kl_min = kl;
+            best = threshold;
+        }
+    }
+    return best + 0.5f;
+}
+
+// Applies f(value) to every element of an fp32 blob, whatever its packing.
+template<typename F>
+static void for_each_value(const ncnn::Mat& blob, F f)
+{
+    const int size = blob.w * blob.h * blob.elempack;
+    for (int q = 0; q < blob.c; q++)
+    {
+        const float* ptr = blob.channel(q);
+        for (int i = 0; i < size; i++)
+            f(ptr[i]);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    std::vector<const char*> paths;
+    int frames = 200;
+    int num_threads = 4;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+            frames = std::max(1, atoi(argv[++i]));
+        else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc)
+            num_threads = std::max(1, atoi(argv[++i]));
+        else if (argv[i][0] != '-')
+            paths.push_back(argv[i]);
+        else
+        {
+            usage(argv[0]);
+            return -1;
+        }
+    }
+    if (paths.size() < 4)
+    {
+        usage(argv[0]);
+        return -1;
+    }
+    std::vector<const char*> videos(paths.begin() + 3, paths.end());
+
+    ncnn::Net net;
+    // fp32 blobs and unpacked weights, which the statistics below read directly
+    net.opt.num_threads = num_threads;
+    net.opt.lightmode = false;
+    net.opt.use_fp16_packed = false;
+    net.opt.use_fp16_storage = false;
+    net.opt.use_fp16_arithmetic = false;
+    net.opt.use_bf16_storage = false;
+    net.opt.use_int8_inference = false;
+    net.register_custom_layer("YoloV5Focus", YoloV5Focus_layer_creator);
+    if (net.load_param(paths[0]) != 0 || net.load_model(paths[1]) != 0)
+    {
+        fprintf(stderr, "Cannot load %s / %s\n", paths[0], paths[1]);
+        return -1;
+    }
+
+    std::vector<QuantLayer> layers;
+    for (size_t i = 0; i < net.layers().size(); i++)
+    {
+        const ncnn::Layer* layer = net.layers()[i];
+        if (layer->type != "Convolution" && layer->type != "ConvolutionDepthWise" && layer->type != "InnerProduct")
+            continue;
+        QuantLayer quant;
+        quant.layer = layer;
+        quant.bottom = layer->bottoms[0];
+        quant.weight_scales = weight_scales(layer);
+        quant.absmax = 0.f;
+        quant.histogram.assign(NUM_HISTOGRAM_BINS, 0.f);
+        quant.bottom_scale = 1.f;
+        layers.push_back(quant);
+    }
+    fprintf(stderr, "%d layers to quantize, %d frames from %d video(s)\n", (int)layers.size(), frames, (int)videos.size());
+
+    // first pass: range of every quantized input, second pass: its histogram
+    for (int pass = 0; pass < 2; pass++)
+    {
+        int done = 0;
+        bool ok = for_each_frame(videos, frames, [&](const ncnn::Mat& in) {
+            ncnn::Extractor ex = net.create_extractor();
+            ex.input("images", in);
+            for (size_t l = 0; l < layers.size(); l++)
+            {
+                QuantLayer& quant = layers[l];
+                ncnn::Mat blob;
+                ex.extract(quant.bottom, blob);
+                if (pass == 0)
+                {
+                    for_each_value(blob, [&](float v) { quant.absmax = std::max(quant.absmax, fabsf(v)); });
+                    continue;
+                }
+                if (quant.absmax == 0.f)
+                    continue;
+                const float bin_scale = NUM_HISTOGRAM_BINS / quant.absmax;
+                for_each_value(blob, [&](float v) {
+                    if (v != 0.f)
+                        quant.histogram[std::min((int)(fabsf(v) * bin_scale), NUM_HISTOGRAM_BINS - 1)] += 1.f;
+                });
+            }
+            if (++done % 20 == 0)
+                fprintf(stderr, "pass %d: %d frames\n", pass + 1, done);
+        });
+        if (!ok)
+            return -1;
+    }
+
+    FILE* table = fopen(paths[2], "wb");
+    if (table == NULL)
+    {
+        fprintf(stderr, "Cannot write %s\n", paths[2]);
+        return -1;
+    }
+    for (size_t l = 0; l < layers.size(); l++)
+    {
+        fprintf(table, "%s_param_0 ", layers[l].layer->name.c_str());
+        for (size_t c = 0; c < layers[l].weight_scales.size(); c++)
+            fprintf(table, "%f ", layers[l].weight_scales[c]);
+        fprintf(table, "\n");
+    }
+    for (size_t l = 0; l < layers.size(); l++)
+    {
+        QuantLayer& quant = layers[l];
+        if (quant.absmax > 0.f)
+        {
+            float threshold = kl_threshold_bin(quant.histogram) * quant.absmax / NUM_HISTOGRAM_BINS;
+            quant.bottom_scale = 127 / threshold;
+        }
+        fprintf(table, "%s %f\n", quant.layer->name.c_str(), quant.bottom_scale);
+        fprintf(stderr, "%-32s absmax %10.4f  scale %10.4f\n", quant.layer->name.c_str(), quant.absmax, quant.bottom_scale);
+    }
+    fclose(table);
+    fprintf(stderr, "wrote %s, now run:\n  ncnn2int8 %s %s <model>-int8.param <model>-int8.bin %s\n", paths[2], paths[0],
+            paths[1], paths[2]);
+    return 0;
+}
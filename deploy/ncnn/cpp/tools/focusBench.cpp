@@ -0,0 +1,115 @@
+#include "layer.h"
+#include "mat.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include "yoloV5Focus.h"
+
+// Times YoloV5Focus on the 1088x608 network input against the scalar layer it replaced,
+// in fp32 and in 16 bit (fp16 / bf16) storage, with and without the packed layout, and
+// checks that both produce the same values. With packing, the old layer wrote pack1 and
+// ncnn converted its output for the next convolution, so that conversion is timed with it.
+//
+//   bytetrack_focus_bench [iterations] [threads]
+
+#define INPUT_W 1088
+#define INPUT_H 608
+
+// the scalar strided gather of the original layer, for any element size
+template<typename T>
+static void reference_focus(const ncnn::Mat& bottom_blob, ncnn::Mat& top_blob, const ncnn::Option& opt)
+{
+    int w = bottom_blob.w;
+    int h = bottom_blob.h;
+    int channels = bottom_blob.c;
+
+    int outw = w / 2;
+    int outh = h / 2;
+    int outc = channels * 4;
+
+    top_blob.create(outw, outh, outc, sizeof(T), 1, opt.blob_allocator);
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int p = 0; p < outc; p++)
+    {
+        const T* ptr = bottom_blob.channel(p % channels).row<const T>((p / channels) % 2) + ((p / channels) / 2);
+        T* outptr = top_blob.channel(p);
+
+        for (int i = 0; i < outh; i++)
+        {
+            for (int j = 0; j < outw; j++)
+            {
+                *outptr = *ptr;
+
+                outptr += 1;
+                ptr += 2;
+            }
+
+            ptr += w;
+        }
+    }
+}
+
+template<typename F>
+static double time_ms(int iterations, F f)
+{
+    f();
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (int n = 0; n < iterations; n++)
+        f();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / iterations;
+}
+
+template<typename T>
+static bool run(const char* storage, bool packing, int iterations, int threads)
+{
+    ncnn::Option opt;
+    opt.num_threads = threads;
+    opt.use_packing_layout = packing;
+
+    ncnn::Mat in(INPUT_W, INPUT_H, 3, sizeof(T));
+    unsigned char* bytes = (unsigned char*)in.data;
+    for (size_t i = 0; i < in.cstep * in.c * sizeof(T); i++)
+        bytes[i] = (unsigned char)rand();
+
+    YoloV5Focus focus;
+    ncnn::Mat reference, reference_packed, out;
+    reference_focus<T>(in, reference, opt);
+    focus.forward(in, out, opt);
+    const int elempack = out.elempack;
+
+    double reference_ms = time_ms(iterations, [&]() {
+        reference_focus<T>(in, reference, opt);
+        if (elempack != 1)
+            ncnn::convert_packing(reference, reference_packed, elempack, opt);
+    });
+    double focus_ms = time_ms(iterations, [&]() { focus.forward(in, out, opt); });
+
+    ncnn::Mat unpacked = out;
+    if (elempack != 1)
+        ncnn::convert_packing(out, unpacked, 1, opt);
+    bool same = unpacked.c == reference.c;
+    for (int q = 0; same && q < reference.c; q++)
+        same = memcmp(unpacked.channel(q), reference.channel(q), (size_t)reference.w * reference.h * sizeof(T)) == 0;
+
+    printf("%-8s pack%-4d %10.3f %10.3f %8.2fx  %s\n", storage, elempack, reference_ms, focus_ms, reference_ms / focus_ms,
+           same ? "same" : "DIFFERENT");
+    return same;
+}
+
+int main(int argc, char** argv)
+{
+    int iterations = argc > 1 ? atoi(argv[1]) : 200;
+    int threads = argc > 2 ? atoi(argv[2]) : 1;
+
+    printf("%dx%d input, %d thread(s)\n", INPUT_W, INPUT_H, threads);
+    printf("storage  layout   scalar ms   focus ms  speedup\n");
+    bool ok = true;
+    ok &= run<float>("fp32", false, iterations, threads);
+    ok &= run<float>("fp32", true, iterations, threads);
+    ok &= run<unsigned short>("fp16", false, iterations, threads);
+    ok &= run<unsigned short>("fp16", true, iterations, threads);
+    return ok ? 0 : -1;
+}
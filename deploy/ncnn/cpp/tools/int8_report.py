@@ -0,0 +1,95 @@
+import argparse
+import configparser
+import os
+import re
+import subprocess
+import sys
+
+import motmetrics as mm
+
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), "../../../.."))
+from yolox.evaluators.evaluation import Evaluator
+
+
+def make_parser():
+    parser = argparse.ArgumentParser("ncnn fp32 vs int8 report")
+    parser.add_argument(
+        "-b",
+        "--binary",
+        type=str,
+        default="./bytetrack",
+        help="The ncnn demo, run from the directory that holds the .param/.bin files.",
+    )
+    parser.add_argument(
+        "-d",
+        "--data_root",
+        type=str,
+        default="datasets/mot/train",
+        help="MOT challenge split with <seq>/img1 and <seq>/gt/gt.txt.",
+    )
+    parser.add_argument(
+        "-s",
+        "--seqs",
+        type=str,
+        nargs="+",
+        default=["MOT17-02-FRCNN", "MOT17-04-FRCNN", "MOT17-09-FRCNN"],
+        help="Sequences to run.",
+    )
+    parser.add_argument(
+        "-o",
+        "--output_dir",
+        type=str,
+        default="int8_report",
+        help="Where the MOT result files of both models go.",
+    )
+    parser.add_argument(
+        "--args",
+        type=str,
+        default="",
+        help="Extra demo options, e.g. \"--pipeline --detectors 2\".",
+    )
+    return parser
+
+
+def seq_frame_rate(data_root, seq):
+    # image sequences carry no frame rate of their own, the tracker needs the real one
+    info = configparser.ConfigParser()
+    info.read(os.path.join(data_root, seq, "seqinfo.ini"))
+    return info.getint("Sequence", "frameRate", fallback=30)
+
+
+def run_demo(args, seq, int8):
+    result = os.path.join(args.output_dir, "int8" if int8 else "fp32", seq + ".txt")
+    os.makedirs(os.path.dirname(result), exist_ok=True)
+    cmd = [args.binary, os.path.join(args.data_root, seq, "img1", "%06d.jpg"), "--headless", "--mot", result,
+           "--fps", str(seq_frame_rate(args.data_root, seq))]
+    cmd += args.args.split()
+    if int8:
+        cmd.append("--int8")
+    out = subprocess.run(cmd, stdout=subprocess.PIPE, universal_newlines=True, check=True).stdout
+    fps = re.findall(r"^FPS: (\d+)", out, re.MULTILINE)
+    return result, int(fps[-1]) if fps else 0
+
+
+def main(args):
+    rows = []
+    for model in ("fp32", "int8"):
+        accs, fps = [], []
+        for seq in args.seqs:
+            result, seq_fps = run_demo(args, seq, model == "int8")
+            accs.append(Evaluator(args.data_root, seq, "mot").eval_file(result))
+            fps.append(seq_fps)
+            print("{} {}: {} FPS".format(model, seq, seq_fps))
+        summary = Evaluator.get_summary(accs, args.seqs, ("mota", "idf1", "num_switches"))
+        print(mm.io.render_summary(summary, formatters=mm.metrics.create().formatters,
+                                   namemap=mm.io.motchallenge_metric_names))
+        overall = summary.loc["OVERALL"]
+        rows.append((model, overall["mota"], overall["idf1"], int(overall["num_switches"]), sum(fps) / len(fps)))
+
+    print("\nmodel    MOTA    IDF1   IDs    FPS")
+    for model, mota, idf1, switches, fps in rows:
+        print("{:<6} {:6.1f}% {:6.1f}% {:5d} {:6.1f}".format(model, mota * 100, idf1 * 100, switches, fps))
+
+
+if __name__ == "__main__":
+    main(make_parser().parse_args())